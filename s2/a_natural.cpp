@@ -5,6 +5,22 @@
 #include <algorithm>
 #include <tuple>
 #include <cmath>
+#include <utility>
+#include <array>
+#include <memory>
+#include <memory_resource>
+#include <iterator>
+#include <random>
+#include <chrono>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <functional>
+#include <deque>
+#include <bit>
+#include <cstring>
 
 /* Tento úkol rozšiřuje ‹s1/f_natural› o tyto operace (hodnoty ‹m› a
  * ‹n› jsou typu ‹natural›):
@@ -38,10 +54,156 @@ int int_bytes( int v ) {
 	return 1;
 }
 
+/* Storage for the digits of ‹natural›: values of up to 128 bits live
+ * in the inline buffer and never touch the heap, larger ones are
+ * moved to a buffer which then grows geometrically. That buffer comes
+ * from a ‹std::pmr::memory_resource› – unless given explicitly, the one
+ * set for the current thread (see ‹natural_arena›) or the default one.
+ * Like with pmr containers, a copy does not inherit the resource and
+ * assignment keeps the resource of the target. */
+
+struct digit_buffer {
+	static constexpr std::size_t inline_digits = 16;
+	static inline std::atomic< std::size_t > heap_allocs = 0;		// for measurements
+	static inline thread_local std::pmr::memory_resource *thread_resource = nullptr;
+
+	static std::pmr::memory_resource *current_resource() {
+		return thread_resource ? thread_resource : std::pmr::get_default_resource();
+	}
+
+	std::pmr::memory_resource *_res = current_resource();
+	std::size_t _size = 0;
+	std::size_t _capacity = inline_digits;
+	std::uint8_t *_heap = nullptr;
+	std::array< std::uint8_t, inline_digits > _inline = {};
+
+	digit_buffer() = default;
+	explicit digit_buffer( std::pmr::memory_resource *res ) : _res( res ) {}
+	digit_buffer( std::size_t n, std::uint8_t val, 
+				  std::pmr::memory_resource *res = current_resource() ) : _res( res ) {
+		resize( n, val );
+	}
+	template< std::input_iterator iter >
+	digit_buffer( iter first, iter last ) {
+		for ( ; first != last; ++first ) push_back( *first );
+	}
+	digit_buffer( const digit_buffer &other, 
+				  std::pmr::memory_resource *res = current_resource() ) : _res( res ) {
+		assign( other );
+	}
+	digit_buffer( digit_buffer &&other ) noexcept : _res( other._res ) { steal( other ); }
+	digit_buffer &operator=( const digit_buffer &other ) {
+		if ( this != &other ) assign( other );
+		return *this;
+	}
+	digit_buffer &operator=( digit_buffer &&other ) noexcept {
+		if ( this == &other ) return *this;
+		if ( *_res == *other._res ) {
+			steal( other );
+		} else {
+			assign( other );
+		}
+		return *this;
+	}
+	~digit_buffer() { release(); }
+
+	std::uint8_t *data() { return _heap ? _heap : _inline.data(); }
+	const std::uint8_t *data() const { return _heap ? _heap : _inline.data(); }
+	std::size_t size() const { return _size; }
+	bool empty() const { return _size == 0; }
+
+	std::uint8_t &operator[]( std::size_t i ) { return data()[i]; }
+	const std::uint8_t &operator[]( std::size_t i ) const { return data()[i]; }
+
+	std::uint8_t *begin() { return data(); }
+	std::uint8_t *end() { return data() + _size; }
+	const std::uint8_t *begin() const { return data(); }
+	const std::uint8_t *end() const { return data() + _size; }
+	auto rbegin() { return std::reverse_iterator( end() ); }
+	auto rend() { return std::reverse_iterator( begin() ); }
+
+	void reserve( std::size_t n ) {
+		if ( n <= _capacity ) return;
+		std::size_t cap = std::max( n, 2 * _capacity );
+		auto *heap = static_cast< std::uint8_t * >( _res->allocate( cap, 1 ) );
+		std::copy( begin(), end(), heap );
+		release();
+		_heap = heap;
+		_capacity = cap;
+		++heap_allocs;
+	}
+	void resize( std::size_t n, std::uint8_t val = 0 ) {
+		reserve( n );
+		if ( n > _size ) std::fill( data() + _size, data() + n, val );
+		_size = n;
+	}
+	void push_back( std::uint8_t d ) {
+		reserve( _size + 1 );
+		data()[ _size++ ] = d;
+	}
+
+	void release() {
+		if ( _heap ) _res->deallocate( _heap, _capacity, 1 );
+		_heap = nullptr;
+		_capacity = inline_digits;
+	}
+	void assign( const digit_buffer &other ) {
+		reserve( other._size );
+		std::copy( other.begin(), other.end(), data() );
+		_size = other._size;
+	}
+	//	other must use the same resource
+	void steal( digit_buffer &other ) {
+		release();
+		if ( other._heap ) {
+			_heap = other._heap;
+			_capacity = other._capacity;
+			other._heap = nullptr;
+			other._capacity = inline_digits;
+		} else {
+			std::copy( other.begin(), other.end(), _inline.data() );
+		}
+		_size = other._size;
+		other._size = 0;
+	}
+
+	friend bool operator==( const digit_buffer &a, const digit_buffer &b ) {
+		return std::equal( a.begin(), a.end(), b.begin(), b.end() );
+	}
+};
+
+/* While an arena is alive, naturals created by the thread which owns
+ * it (including the temporaries of the arithmetic) allocate from a
+ * monotonic buffer, which is thrown away as a whole by ‹reset› – call
+ * it between jobs, once nothing allocated in the previous one is used.
+ * Results have to be copied (not moved) to a value living outside. */
+
+struct natural_arena {
+	std::pmr::monotonic_buffer_resource _arena;
+	std::pmr::memory_resource *_outer;
+
+	natural_arena() : _outer( digit_buffer::thread_resource ) {
+		digit_buffer::thread_resource = &_arena;
+	}
+	natural_arena( const natural_arena & ) = delete;
+	natural_arena &operator=( const natural_arena & ) = delete;
+	~natural_arena() { digit_buffer::thread_resource = _outer; }
+
+	void reset() { _arena.release(); }
+};
+
+//	per-thread pool for the temporaries of the multiplication and division kernels
+std::pmr::memory_resource *scratch_resource() {
+	thread_local std::pmr::unsynchronized_pool_resource pool;
+	return &pool;
+}
+
 struct natural {
-	std::vector< std::uint8_t > _digits;
+	digit_buffer _digits;
 
 	natural() : _digits( 1, 0 ) {}
+	explicit natural( std::pmr::memory_resource *res ) : _digits( 1, 0, res ) {}
+	natural( const natural &other, std::pmr::memory_resource *res ) : _digits( other._digits, res ) {}
 	natural( int val ) : _digits( int_bytes(val), 0 ) {
 		assert( val >= 0 );
 		for ( int i = 0; i < int_bytes(val); i++ ) {
@@ -59,7 +221,7 @@ struct natural {
 		}
 		if ( _digits.empty() ) _digits.push_back( 0 );
 	}
-	natural( std::vector<std::uint8_t> vec ) : _digits(vec) {}
+	natural( const std::vector<std::uint8_t> &vec ) : _digits( vec.begin(), vec.end() ) {}
 
 	std::size_t digit_count() const {
 		return _digits.size();
@@ -93,6 +255,24 @@ struct natural {
 		_digits.resize( _digits.size() - zero_digs );
 	}
 	
+	//	values of at most 8 digits fit into a machine word, the arithmetic
+	//	below takes a fast path when this is true of its operands
+	std::uint64_t to_u64() const {
+		assert( digit_count() <= 8 );
+		std::uint64_t val = 0;
+		for ( std::size_t i = digit_count(); i > 0; --i ) {
+			val = ( val << 8 ) | _digits[i-1];
+		}
+		return val;
+	}
+	void set_u64( std::uint64_t val ) {
+		_digits.resize( 0 );
+		do {
+			_digits.push_back( val & 255 );
+			val >>= 8;
+		} while ( val );
+	}
+
 	std::vector<natural> digits( const natural &n );
 	natural power( int p );
 };
@@ -112,123 +292,300 @@ void print( std::vector<int> v ) {
 	std::cout << "> ";
 }
 
+/* Comparisons do not exit early: for operands of the same length every
+ * digit pair is visited and the outcome is folded in with masks, so
+ * their running time depends only on the lengths. */
+
 bool operator==( const natural &a, const natural &b ) {
 	if ( a.digit_count() != b.digit_count() ) return false;
-	return a._digits == b._digits;
+	std::uint8_t diff = 0;
+	for ( std::size_t i = 0; i < a.digit_count(); ++i ) diff |= a[i] ^ b[i];
+	return diff == 0;
 }
 bool operator!=( const natural &a, const natural &b ) {
 	return !( a == b );
 }
 
-bool less_than( const natural &a, const natural &b, bool eq ) {
+//	-1, 0 or 1 as a is less than, equal to or greater than b
+int compare( const natural &a, const natural &b ) {
 	if ( a.digit_count() != b.digit_count() ) {
-		return a.digit_count() < b.digit_count();
+		return a.digit_count() < b.digit_count() ? -1 : 1;
 	}
-	for ( std::size_t i = a.digit_count(); i > 0; --i ) {
-		if ( a[i-1] != b[i-1] ) {
-			return a[i-1] < b[i-1];
+	auto fold = []( int res, auto x, auto y ) {		// a higher digit overrides
+		int sign = ( x > y ) - ( x < y );
+		return sign | ( res & -int( sign == 0 ) );
+	};
+	int res = 0;
+	std::size_t i = 0;
+	if constexpr ( std::endian::native == std::endian::little ) {
+		for ( ; i + 8 <= a.digit_count(); i += 8 ) {
+			std::uint64_t u, v;
+			std::memcpy( &u, a._digits.data() + i, 8 );
+			std::memcpy( &v, b._digits.data() + i, 8 );
+			res = fold( res, u, v );
 		}
 	}
-	return eq;
+	for ( ; i < a.digit_count(); ++i ) res = fold( res, a[i], b[i] );
+	return res;
 }
 bool operator<( const natural &a, const natural &b ) {
-	return less_than( a, b, false );
+	return compare( a, b ) < 0;
 }
 bool operator>( const natural &a, const natural &b ) {
-	return less_than( b, a, false );
+	return compare( a, b ) > 0;
 }
 bool operator<=( const natural &a, const natural &b ) {
-	return less_than( a, b, true );
+	return compare( a, b ) <= 0;
 }
 bool operator>=( const natural &a, const natural &b ) {
-	return less_than( b, a, true );
+	return compare( a, b ) >= 0;
 }
 
-natural add( const natural &a, const natural &b, bool subtract ) {
+/* Kernels working in place on the digits of their left operand –
+ * compound assignment reuses the capacity already held by it and
+ * the value-returning operators are built on top of them.
+ *
+ * Addition and subtraction are chosen at compile time. The digits
+ * shared with ‹b› are processed 8 at a time as 64-bit words with the
+ * carry computed by comparisons rather than branches, leftover
+ * digits one by one; only the final carry propagation into the
+ * higher digits of ‹a› stops as soon as the carry is gone. */
+
+template< bool subtract >
+void add_to( natural &a, const natural &b ) {
 	if ( subtract ) assert ( a >= b );
-	std::size_t res_size = std::max( a.digit_count(), b.digit_count() );
-	natural res( res_size, 0 );
-	std::int16_t a_val = 0, b_val = 0, dig_val = 0, carry = 0;
-	for ( std::size_t i = 0; i < res.digit_count(); ++i ) {
-		a_val = ( i < a.digit_count() ) ? a[i] : 0;
-		b_val = ( i < b.digit_count() ) ? b[i] : 0;
-		dig_val = ( subtract ) ? (a_val - b_val - carry) : (a_val + b_val + carry);
-		if ( 	 !subtract && (dig_val >> 8) ) {
-			carry = 1;
-			res[i] = dig_val & 255;
-		}
-		else if ( subtract && (dig_val < 0) ) {
-			carry = 1;
-			res[i] = ( 1UL << 8 ) + dig_val;
-		} else {
-			carry = 0;
-			res[i] = dig_val;
+	if ( a.digit_count() < 8 && b.digit_count() < 8 ) {
+		a.set_u64( subtract ? a.to_u64() - b.to_u64() : a.to_u64() + b.to_u64() );
+		return;
+	}
+	if ( a.digit_count() < b.digit_count() ) a._digits.resize( b.digit_count() );
+	std::uint8_t *x = a._digits.data();
+	const std::uint8_t *y = b._digits.data();
+	std::size_t n = b.digit_count(), i = 0;
+	std::uint64_t carry = 0;
+	if constexpr ( std::endian::native == std::endian::little ) {
+		for ( ; i + 8 <= n; i += 8 ) {
+			std::uint64_t u, v, r;
+			std::memcpy( &u, x + i, 8 );
+			std::memcpy( &v, y + i, 8 );
+			if constexpr ( subtract ) {
+				r = u - v - carry;
+				carry = ( u < v ) | ( ( u == v ) & carry );
+			} else {
+				r = u + v + carry;
+				carry = ( r < u ) | ( ( r == u ) & carry );
+			}
+			std::memcpy( x + i, &r, 8 );
 		}
 	}
-	if ( !subtract && carry ) {
-		res.add_digits( 1 );
-		res[ res.digit_count()-1 ] = carry;
+	for ( ; i < n; ++i ) {
+		std::uint16_t r = subtract ? x[i] - y[i] - carry : x[i] + y[i] + carry;
+		x[i] = r & 255;
+		carry = ( r >> 8 ) & 1;
 	}
-	res.remove_zero_digits();
-	return res;	
+	for ( ; carry && i < a.digit_count(); ++i ) {
+		std::uint16_t r = subtract ? x[i] - carry : x[i] + carry;
+		x[i] = r & 255;
+		carry = ( r >> 8 ) & 1;
+	}
+	if ( !subtract && carry ) a._digits.push_back( carry );
+	a.remove_zero_digits();
+}
+
+template< bool subtract >
+natural add( const natural &a, const natural &b ) {
+	natural res = a;
+	add_to< subtract >( res, b );
+	return res;
 }
 
-natural operator+( const natural &a, const natural &b ) { return add( a, b, false ); }
-natural operator-( const natural &a, const natural &b ) { return add( a, b, true ); }
+natural operator+( const natural &a, const natural &b ) { return add< false >( a, b ); }
+natural operator-( const natural &a, const natural &b ) { return add< true >( a, b ); }
+natural &operator+=( natural &a, const natural &b ) { add_to< false >( a, b ); return a; }
+natural &operator-=( natural &a, const natural &b ) { add_to< true >( a, b ); return a; }
 
-natural operator*( const natural &a, const natural &b ) {
-	std::size_t res_size = a.digit_count() + b.digit_count();
-	natural zeros( res_size, 0 ), res( res_size, 0 ), 
-			dig_res( res_size, 0 ), carry( res_size, 0 );
-	std::uint16_t a_val, b_val, dig_val = 0;
+//	adds d * b to the digits starting at index off ( they must be wide enough )
+void mul_digit_add( digit_buffer &digs, std::size_t off, 
+					const natural &b, std::uint8_t d ) {
+	if ( d == 0 ) return;
+	std::uint16_t dig_val = 0, carry = 0;
+	std::size_t i = 0;
+	for ( ; i < b.digit_count(); ++i ) {
+		dig_val = digs[off+i] + d * b[i] + carry;
+		digs[off+i] = dig_val & 255;
+		carry = dig_val >> 8;
+	}
+	for ( ; carry; ++i ) {
+		dig_val = digs[off+i] + carry;
+		digs[off+i] = dig_val & 255;
+		carry = dig_val >> 8;
+	}
+}
+
+//	operands with at least this many digits are multiplied by karatsuba
+std::size_t karatsuba_threshold = 48;
+natural karatsuba( const natural &a, const natural &b );
+
+//	dst += a * b in a single pass over the digits of dst 
+//	( dst must not be the same object as a or b )
+void mul_add( natural &dst, const natural &a, const natural &b ) {
+	assert( &dst != &a && &dst != &b );
+	if ( std::min( a.digit_count(), b.digit_count() ) >= karatsuba_threshold ) {
+		dst += karatsuba( a, b );
+		return;
+	}
+	if ( dst.digit_count() < 8 && a.digit_count() + b.digit_count() < 8 ) {
+		dst.set_u64( dst.to_u64() + a.to_u64() * b.to_u64() );
+		return;
+	}
+	std::size_t res_size = std::max( dst.digit_count(), a.digit_count() + b.digit_count() ) + 1;
+	dst._digits.resize( res_size );
 	for ( std::size_t i = 0; i < a.digit_count(); ++i ) {
-		dig_res = zeros;
-		carry = zeros;
-		for ( std::size_t j = 0; j < b.digit_count(); ++j ) {
-			a_val = a[i];
-			b_val = b[j];
-			dig_val = a_val * b_val;
-			carry[ i + j + 1 ] = dig_val >> 8;
-			dig_res[ i + j ] = dig_val & ( (1UL << 8) - 1 );
-		}
-		res = res + dig_res + carry;
-	}	
-	res.remove_zero_digits();
-	return res;	
+		mul_digit_add( dst._digits, i, b, a[i] );
+	}
+	dst.remove_zero_digits();
+}
+
+//	the digits of a are consumed from the most significant one, so every
+//	partial product only ever lands on digits that were already consumed
+natural &operator*=( natural &a, const natural &b ) {
+	if ( &a == &b ) {
+		natural b_copy( b, scratch_resource() );
+		return a *= b_copy;
+	}
+	if ( a.digit_count() + b.digit_count() <= 8 ) {
+		a.set_u64( a.to_u64() * b.to_u64() );
+		return a;
+	}
+	if ( std::min( a.digit_count(), b.digit_count() ) >= karatsuba_threshold ) {
+		a = karatsuba( a, b );
+		return a;
+	}
+	std::size_t a_size = a.digit_count();
+	a.add_digits( b.digit_count() );
+	for ( std::size_t i = a_size; i > 0; --i ) {
+		std::uint8_t d = a[i-1];
+		a[i-1] = 0;
+		mul_digit_add( a._digits, i-1, b, d );
+	}
+	a.remove_zero_digits();
+	return a;
 }
 
-void operator<<=( natural &n, int off ) {
-	n.add_digits(1);
-	for ( auto i = n.digit_count(); i > 1; --i ) {
-		n[i-1] = ( n[i-1] << off ) | ( n[i-2] >> (8-off) );	
+/* ‹a * b› is an expression template: the product is only computed
+ * when it is converted to ‹natural›, or – if it is directly followed
+ * by an addition, as in ‹a * b + c› – it is accumulated straight into
+ * the buffer holding the sum (see ‹mul_add›), without a temporary for
+ * the product. It keeps references to its operands, so do not store
+ * it in an ‹auto› variable past the end of the full expression. */
+
+struct natural_product {
+	const natural &a, &b;
+
+	operator natural() const {
+		natural res;
+		mul_add( res, a, b );
+		return res;
 	}
-	n[0] = n[0] << off;
+};
+
+natural_product operator*( const natural &a, const natural &b ) { return { a, b }; }
+
+natural operator+( const natural_product &p, const natural &c ) {
+	natural res = c;
+	mul_add( res, p.a, p.b );
+	return res;
+}
+natural operator+( const natural &c, const natural_product &p ) { return p + c; }
+natural operator+( const natural_product &p, const natural_product &r ) {
+	return p + static_cast<natural>( r );
+}
+
+std::size_t bit_count( const natural &n ) {
+	std::size_t bits = 8 * ( n.digit_count() - 1 );
+	for ( std::uint8_t top = n[ n.digit_count()-1 ]; top; top >>= 1 ) ++bits;
+	return bits;
+}
+bool bit( const natural &n, std::size_t i ) {
+	return ( n[ i / 8 ] >> ( i % 8 ) ) & 1;
+}
+
+/* Shifts by any number of bits in a single pass: whole digits move by
+ * the index offset, and each digit of the result combines the two
+ * neighbouring source digits. */
+
+natural &operator<<=( natural &n, std::size_t bits ) {
+	std::size_t k = bits / 8, s = bits % 8, size = n.digit_count();
+	n._digits.resize( size + k + 1 );
+	for ( std::size_t i = size + k + 1; i-- > k; ) {
+		std::uint8_t hi = ( i - k < size ) ? n[ i-k ] : 0,
+					 lo = ( i > k ) ? n[ i-k-1 ] : 0;
+		n[i] = ( hi << s ) | ( lo >> ( 8 - s ) );
+	}
+	std::fill( n._digits.begin(), n._digits.begin() + k, 0 );
 	n.remove_zero_digits();
+	return n;
 }
-void operator>>=( natural &n, int off ) {
-	for ( std::size_t i = 0; i < n.digit_count()-1; ++i ) {
-		n[i] = ( n[i] >> off ) | ( n[i+1] << (8-off) );
+natural &operator>>=( natural &n, std::size_t bits ) {
+	std::size_t k = bits / 8, s = bits % 8, size = n.digit_count();
+	if ( k >= size ) {
+		n._digits.resize( 1 );
+		n[0] = 0;
+		return n;
+	}
+	for ( std::size_t i = 0; i + k < size; ++i ) {
+		std::uint8_t hi = ( i + k + 1 < size ) ? n[ i+k+1 ] : 0;
+		n[i] = ( n[ i+k ] >> s ) | ( hi << ( 8 - s ) );
 	}
-	n[ n.digit_count()-1 ] = n[ n.digit_count()-1 ] >> off;
+	n._digits.resize( size - k );
 	n.remove_zero_digits();
+	return n;
+}
+natural operator<<( natural n, std::size_t bits ) { return n <<= bits; }
+natural operator>>( natural n, std::size_t bits ) { return n >>= bits; }
+
+//	a -= b · 2ᵇⁱᵗˢ unless that would go below zero – the shifted b is
+//	never built, its digits are computed on the fly by both the
+//	comparison and the subtraction
+bool sub_shifted( natural &a, const natural &b, std::size_t bits ) {
+	if ( b == natural( 0 ) ) return true;
+	std::size_t k = bits / 8, s = bits % 8;
+	auto digit = [&]( std::size_t i ) -> std::uint8_t {
+		if ( i < k ) return 0;
+		std::uint8_t hi = ( i - k < b.digit_count() ) ? b[ i-k ] : 0,
+					 lo = ( i > k && i - k - 1 < b.digit_count() ) ? b[ i-k-1 ] : 0;
+		return ( hi << s ) | ( lo >> ( 8 - s ) );
+	};
+	std::size_t len = ( bit_count( b ) + bits + 7 ) / 8;
+	if ( len > a.digit_count() ) return false;
+	for ( std::size_t i = len; len == a.digit_count() && i > 0; --i ) {
+		if ( a[i-1] != digit( i-1 ) ) {
+			if ( a[i-1] < digit( i-1 ) ) return false;
+			break;
+		}
+	}
+	std::uint16_t borrow = 0;
+	for ( std::size_t i = k; i < len || ( borrow && i < a.digit_count() ); ++i ) {
+		std::uint16_t r = a[i] - digit( i ) - borrow;
+		a[i] = r & 255;
+		borrow = ( r >> 8 ) & 1;
+	}
+	a.remove_zero_digits();
+	return true;
 }
 
 std::uint8_t short_div( auto &it_start, auto &it_end, const natural &denom ) {
-	natural den = denom;
-	std::vector<std::uint8_t> nomvec(it_start, it_end);
-	std::reverse( nomvec.begin(), nomvec.end() );
-	natural nom( nomvec );
+	natural nom( scratch_resource() );
+	nom._digits.resize( 0 );
+	for ( auto it = it_end; it != it_start; ) {
+		nom._digits.push_back( *--it );
+	}
 	if ( nom < denom ) {
 		return 0;
 	}
 	std::uint8_t res = 0;
-	den <<= 7;
-	for ( int bit_off = 0; bit_off < 8; ++bit_off ) {
-		if ( den <= nom ) {
-			nom = nom - den;
-			res = res | ( 1 << (7-bit_off) );
-		}
-		den >>= 1;
+	for ( int bit_off = 7; bit_off >= 0; --bit_off ) {
+		if ( sub_shifted( nom, denom, bit_off ) ) res |= 1 << bit_off;
 	}
 
 	auto it = it_start;
@@ -239,10 +596,20 @@ std::uint8_t short_div( auto &it_start, auto &it_end, const natural &denom ) {
 	return res;
 }
 
-std::tuple<natural,natural> divide( const natural &num, const natural &denom ) {
-	if ( num < denom ) return { natural(), num };
-	natural div( num.digit_count() - denom.digit_count() + 1, 0 );
-	natural rem = num;
+//	divides rem by denom, leaves the remainder in rem and returns the quotient
+natural divide_in_place( natural &rem, const natural &denom ) {
+	if ( &rem == &denom ) {
+		rem = natural();
+		return natural( 1 );
+	}
+	if ( rem < denom ) return natural();
+	if ( rem.digit_count() <= 8 ) {
+		natural div;
+		div.set_u64( rem.to_u64() / denom.to_u64() );
+		rem.set_u64( rem.to_u64() % denom.to_u64() );
+		return div;
+	}
+	natural div( rem.digit_count() - denom.digit_count() + 1, 0 );
 	auto it_start = rem._digits.rbegin();
 	auto it_end = rem._digits.rbegin() + denom.digit_count();
 	for ( std::size_t i = div.digit_count(); i > 0; --i ) {
@@ -252,6 +619,12 @@ std::tuple<natural,natural> divide( const natural &num, const natural &denom ) {
 	}
 	div.remove_zero_digits();
 	rem.remove_zero_digits();
+	return div;
+}
+
+std::tuple<natural,natural> divide( const natural &num, const natural &denom ) {
+	natural rem = num;
+	natural div = divide_in_place( rem, denom );
 	return { div, rem };
 }
 
@@ -265,16 +638,14 @@ natural operator%( const natural &a, const natural &b ) {
 	return rem;
 }
 
-std::vector<natural> natural::digits( const natural &n ) {
-	natural t = *this;
-	std::vector<natural> res;
-	while( t != natural(0) ) {
-		auto [div, rem] = divide( t, n );
-		res.push_back( rem );
-		t = div;
-	}
-	std::reverse(res.begin(), res.end());
-	return res;
+natural &operator/=( natural &a, const natural &b ) {
+	natural div = divide_in_place( a, b );
+	a = std::move( div );
+	return a;
+}
+natural &operator%=( natural &a, const natural &b ) {
+	divide_in_place( a, b );
+	return a;
 }
 
 // implementing the exponentiation by squaring algorithm
@@ -283,15 +654,351 @@ natural natural::power( int p ) {
 	natural res(1);
 	if ( p == 0 ) return res;
 	while ( p > 1 ) {
-		if ( p % 2 == 0 ) {
-			p = p/2;
-		} else {
-			res = base * res;
-			p = (p-1)/2;
+		if ( p % 2 == 1 ) res *= base;
+		p = p/2;
+		base *= base;
+	}
+	res *= base;
+	return res;
+}
+
+// ================ MODULAR EXPONENTIATION =====================
+
+//	multiplication / division by 256ᵏ
+natural shift_digits_left( const natural &n, std::size_t k ) {
+	natural res;
+	res._digits.resize( n.digit_count() + k );
+	std::copy( n._digits.begin(), n._digits.end(), res._digits.begin() + k );
+	res.remove_zero_digits();
+	return res;
+}
+natural shift_digits_right( const natural &n, std::size_t k ) {
+	if ( k >= n.digit_count() ) return natural();
+	natural res;
+	res._digits.resize( n.digit_count() - k );
+	std::copy( n._digits.begin() + k, n._digits.end(), res._digits.begin() );
+	return res;
+}
+
+/* Montgomery multiplication for an odd modulus m of n digits: values
+ * are kept as x·R mod m where R = 256ⁿ, and the product of two such
+ * values is reduced digit by digit (CIOS), so that no division is
+ * needed – only the conversions in and out use ‹%›. */
+
+struct montgomery {
+	natural _mod;
+	std::size_t _n;
+	std::uint8_t _m_inv;		// -m⁻¹ mod 256
+
+	explicit montgomery( const natural &mod ) : _mod( mod ), _n( mod.digit_count() ) {
+		assert( mod[0] % 2 == 1 );
+		std::uint8_t inv = mod[0];		// correct to 3 bits, each step doubles that
+		for ( int i = 0; i < 2; ++i ) inv *= 2 - mod[0] * inv;
+		_m_inv = -inv;
+	}
+
+	natural to_mont( const natural &x ) const { return shift_digits_left( x, _n ) % _mod; }
+	natural from_mont( const natural &x ) const { return mul( x, natural( 1 ) ); }
+
+	natural mul( const natural &a, const natural &b ) const {
+		natural t( scratch_resource() );
+		t._digits.resize( _n + 2 );
+		std::fill( t._digits.begin(), t._digits.end(), 0 );
+		std::uint32_t uv = 0, carry = 0;
+		for ( std::size_t i = 0; i < _n; ++i ) {
+			std::uint32_t a_i = ( i < a.digit_count() ) ? a[i] : 0;
+			carry = 0;
+			for ( std::size_t j = 0; j < _n; ++j ) {
+				uv = t[j] + a_i * ( j < b.digit_count() ? b[j] : 0 ) + carry;
+				t[j] = uv & 255;
+				carry = uv >> 8;
+			}
+			uv = t[_n] + carry;
+			t[_n] = uv & 255;
+			t[_n+1] = uv >> 8;
+
+			std::uint32_t m = static_cast<std::uint8_t>( t[0] * _m_inv );
+			carry = ( t[0] + m * _mod[0] ) >> 8;
+			for ( std::size_t j = 1; j < _n; ++j ) {
+				uv = t[j] + m * _mod[j] + carry;
+				t[j-1] = uv & 255;
+				carry = uv >> 8;
+			}
+			uv = t[_n] + carry;
+			t[_n-1] = uv & 255;
+			t[_n] = t[_n+1] + ( uv >> 8 );
+			t[_n+1] = 0;
+		}
+		t.remove_zero_digits();
+		if ( t >= _mod ) t -= _mod;
+		return natural( t, digit_buffer::current_resource() );
+	}
+};
+
+/* Barrett reduction for the remaining (even) moduli: with μ = ⌊256²ⁿ / m⌋
+ * computed once, the quotient of any x < m² is estimated by two
+ * multiplications and is off by at most 2. */
+
+struct barrett {
+	natural _mod, _mu;
+	std::size_t _n;
+
+	explicit barrett( const natural &mod ) 
+		: _mod( mod ), _mu( shift_digits_left( natural( 1 ), 2 * mod.digit_count() ) / mod ),
+		  _n( mod.digit_count() ) {}
+
+	natural to_mont( const natural &x ) const { return x % _mod; }
+	natural from_mont( const natural &x ) const { return x; }
+
+	natural mul( const natural &a, const natural &b ) const {
+		natural x = a * b;
+		natural q = shift_digits_right( shift_digits_right( x, _n - 1 ) * _mu, _n + 1 );
+		q *= _mod;
+		x -= q;
+		while ( x >= _mod ) x -= _mod;
+		return x;
+	}
+};
+
+std::size_t window_size( std::size_t exp_bits ) {
+	if ( exp_bits <= 24 )  return 1;
+	if ( exp_bits <= 80 )  return 3;
+	if ( exp_bits <= 240 ) return 4;
+	if ( exp_bits <= 672 ) return 5;
+	return 6;
+}
+
+//	left-to-right sliding window exponentiation over the given reduction
+template< typename reduction >
+natural window_pow( const reduction &red, const natural &base, const natural &exp ) {
+	std::size_t k = window_size( bit_count( exp ) );
+	std::vector<natural> odd_powers{ red.to_mont( base ) };		// base¹, base³, …
+	natural base_sq = red.mul( odd_powers[0], odd_powers[0] );
+	for ( std::size_t i = 1; i < ( std::size_t( 1 ) << ( k - 1 ) ); ++i ) {
+		odd_powers.push_back( red.mul( odd_powers[i-1], base_sq ) );
+	}
+
+	natural res = red.to_mont( natural( 1 ) );
+	std::size_t i = bit_count( exp );
+	while ( i > 0 ) {
+		if ( !bit( exp, i-1 ) ) {
+			res = red.mul( res, res );
+			--i;
+			continue;
+		}
+		std::size_t low = ( i > k ) ? i - k : 0;
+		while ( !bit( exp, low ) ) ++low;
+		std::size_t window = 0;
+		for ( std::size_t j = i; j > low; --j ) {
+			res = red.mul( res, res );
+			window = ( window << 1 ) | bit( exp, j-1 );
+		}
+		res = red.mul( res, odd_powers[ window / 2 ] );
+		i = low;
+	}
+	return red.from_mont( res );
+}
+
+natural pow_mod( const natural &base, const natural &exp, const natural &mod ) {
+	if ( mod == natural( 1 ) ) return natural();
+	if ( exp == natural( 0 ) ) return natural( 1 );
+	if ( mod[0] % 2 == 1 ) return window_pow( montgomery( mod ), base % mod, exp );
+	return window_pow( barrett( mod ), base % mod, exp );
+}
+
+// ================ PARALLEL =====================
+
+/* Worker threads shared by all the parallel kernels below. Work is only
+ * forked for operands of at least ‹min_grain› digits, so that small
+ * operations never pay for the synchronisation. A thread waiting for a
+ * forked task runs queued tasks in the meantime, hence nested forks
+ * (as in the recursion of karatsuba) cannot exhaust the pool. */
+
+struct task_pool {
+	static inline std::size_t min_grain = 4096;
+
+	std::mutex _lock;
+	std::condition_variable _wake;
+	std::deque< std::function< void() > > _queue;
+	std::vector< std::thread > _workers;
+	bool _stop = false;
+
+	explicit task_pool( unsigned threads ) {
+		for ( unsigned i = 0; i < threads; ++i ) {
+			_workers.emplace_back( [ this ] { work(); } );
+		}
+	}
+	task_pool( const task_pool & ) = delete;
+	task_pool &operator=( const task_pool & ) = delete;
+	~task_pool() {
+		{
+			std::lock_guard< std::mutex > guard( _lock );
+			_stop = true;
+		}
+		_wake.notify_all();
+		for ( auto &w : _workers ) w.join();
+	}
+
+	void work() {
+		while ( true ) {
+			std::function< void() > task;
+			{
+				std::unique_lock< std::mutex > guard( _lock );
+				_wake.wait( guard, [ this ] { return _stop || !_queue.empty(); } );
+				if ( _queue.empty() ) return;
+				task = std::move( _queue.front() );
+				_queue.pop_front();
+			}
+			task();
+		}
+	}
+
+	bool run_one() {
+		std::function< void() > task;
+		{
+			std::lock_guard< std::mutex > guard( _lock );
+			if ( _queue.empty() ) return false;
+			task = std::move( _queue.front() );
+			_queue.pop_front();
+		}
+		task();
+		return true;
+	}
+
+	template< typename fn_t >
+	auto fork( fn_t fn ) {
+		auto task = std::make_shared< std::packaged_task< decltype( fn() )() > >( std::move( fn ) );
+		auto res = task->get_future();
+		{
+			std::lock_guard< std::mutex > guard( _lock );
+			_queue.emplace_back( [ task ] { ( *task )(); } );
 		}
-		base = base * base;
+		_wake.notify_one();
+		return res;
 	}
-	return base*res;
+
+	template< typename T >
+	T join( std::future< T > &res ) {
+		while ( res.wait_for( std::chrono::seconds( 0 ) ) != std::future_status::ready ) {
+			if ( !run_one() ) res.wait_for( std::chrono::microseconds( 50 ) );
+		}
+		return res.get();
+	}
+};
+
+task_pool &shared_pool() {
+	static task_pool pool( std::max( 1u, std::thread::hardware_concurrency() ) );
+	return pool;
+}
+
+//	the lowest k digits of n
+natural low_digits( const natural &n, std::size_t k ) {
+	if ( k >= n.digit_count() ) return n;
+	natural res;
+	res._digits.resize( k );
+	std::copy( n._digits.begin(), n._digits.begin() + k, res._digits.begin() );
+	res.remove_zero_digits();
+	return res;
+}
+
+//	dst += n · 256ᵒᶠᶠ
+void add_at( natural &dst, const natural &n, std::size_t off ) {
+	if ( dst.digit_count() < n.digit_count() + off ) dst._digits.resize( n.digit_count() + off );
+	std::uint16_t dig_val = 0, carry = 0;
+	std::size_t i = 0;
+	for ( ; i < n.digit_count(); ++i ) {
+		dig_val = dst[ off+i ] + n[i] + carry;
+		dst[ off+i ] = dig_val & 255;
+		carry = dig_val >> 8;
+	}
+	for ( ; carry && off + i < dst.digit_count(); ++i ) {
+		dig_val = dst[ off+i ] + carry;
+		dst[ off+i ] = dig_val & 255;
+		carry = dig_val >> 8;
+	}
+	if ( carry ) dst._digits.push_back( carry );
+	dst.remove_zero_digits();
+}
+
+/* Karatsuba: with a = a₁·Bᵐ + a₀ and b = b₁·Bᵐ + b₀, three half-size
+ * products suffice: a₀b₀, a₁b₁ and ( a₀ + a₁ )( b₀ + b₁ ). Above the
+ * grain size, two of them are forked to the pool. */
+
+natural karatsuba( const natural &a, const natural &b ) {
+	if ( std::min( a.digit_count(), b.digit_count() ) < karatsuba_threshold ) {
+		natural res;
+		mul_add( res, a, b );
+		return res;
+	}
+	std::size_t m = std::max( a.digit_count(), b.digit_count() ) / 2;
+	if ( b.digit_count() <= m ) return karatsuba( b, a );
+	bool fork = std::min( a.digit_count(), b.digit_count() ) >= task_pool::min_grain;
+	natural a0 = low_digits( a, m ), a1 = shift_digits_right( a, m ),
+			b0 = low_digits( b, m ), b1 = shift_digits_right( b, m );
+
+	natural res;
+	if ( a.digit_count() <= m ) {		// b is the longer one and a does not split
+		res = karatsuba( a, b0 );
+		add_at( res, karatsuba( a, b1 ), m );
+		return res;
+	}
+	auto high = [ & ] { return karatsuba( a1, b1 ); };
+	auto mid = [ & ] { return karatsuba( a0 + a1, b0 + b1 ); };
+	natural z0, z1, z2;
+	if ( fork ) {
+		auto z2_future = shared_pool().fork( high );
+		auto z1_future = shared_pool().fork( mid );
+		z0 = karatsuba( a0, b0 );
+		z2 = shared_pool().join( z2_future );
+		z1 = shared_pool().join( z1_future );
+	} else {
+		z0 = karatsuba( a0, b0 );
+		z2 = high();
+		z1 = mid();
+	}
+	z1 -= z0;
+	z1 -= z2;
+	res = z0;
+	add_at( res, z1, m );
+	add_at( res, z2, 2 * m );
+	return res;
+}
+
+/* Radix conversion by divide and conquer: with the powers n¹, n², n⁴, …
+ * of the base, splitting by n^2ⁱ gives two halves of 2ⁱ digits each,
+ * which are converted independently (and in parallel above the grain
+ * size) into adjacent parts of the result. */
+
+void convert_digits( const natural &x, const std::vector<natural> &powers, std::size_t level,
+					 std::vector<natural>::iterator out ) {
+	if ( level == 0 ) {
+		*out = x;
+		return;
+	}
+	auto [ high, low ] = divide( x, powers[ level-1 ] );
+	std::size_t half = std::size_t( 1 ) << ( level - 1 );
+	if ( x.digit_count() >= task_pool::min_grain ) {
+		auto high_done = shared_pool().fork( [ &, level ] { 
+			convert_digits( high, powers, level - 1, out ); } );
+		convert_digits( low, powers, level - 1, out + half );
+		shared_pool().join( high_done );
+	} else {
+		convert_digits( high, powers, level - 1, out );
+		convert_digits( low, powers, level - 1, out + half );
+	}
+}
+
+std::vector<natural> natural::digits( const natural &n ) {
+	std::vector<natural> res;
+	if ( *this == natural( 0 ) ) return res;
+	std::vector<natural> powers{ n };
+	while ( powers.back() <= *this ) powers.push_back( powers.back() * powers.back() );
+	res.resize( std::size_t( 1 ) << powers.size() );
+	convert_digits( *this, powers, powers.size(), res.begin() );
+	auto first = std::find_if( res.begin(), res.end(), 
+							   []( const natural &d ) { return d != natural( 0 ); } );
+	res.erase( res.begin(), first );
+	return res;
 }
 
 void test_division() {
@@ -333,6 +1040,272 @@ void test_double() {
 	assert( three_over != three_under );
 }
 
+void test_compound() {
+	std::cout << "TEST COMPOUND" << std::endl;
+	natural a( 13 ), b( 9 ), c( 13 ), d( 9 );
+	for ( int i = 1; i < 5; ++i ) {
+		natural iter( i );
+		b = b * b + a + iter;
+		a = a * a + b;
+		d *= d;
+		d += c;
+		d += iter;
+		natural c_sq = c;
+		c_sq *= c;
+		c_sq += d;
+		c = c_sq;
+		assert( a == c );
+		assert( b == d );
+		assert( a - b > b );
+	}
+
+	natural m( 789123 ), n( 45621 ), r = m;
+	r /= n;
+	assert( r == natural(17) );
+	r = m;
+	r %= n;
+	assert( r == natural(13566) );
+	r -= natural(13566);
+	assert( r == natural(0) );
+	r = m;
+	r /= r;
+	assert( r == natural(1) );
+	assert( natural(3).power( 10 ) == natural(59049) );
+	assert( natural( m * n ) == natural( 36000580383.0 ) );
+}
+
+void test_small() {
+	std::cout << "TEST SMALL" << std::endl;
+	std::size_t allocs = digit_buffer::heap_allocs;
+	natural acc;
+	for ( int i = 0; i < 1000; ++i ) {
+		natural x( i ), y( 977 );
+		acc = x * y + natural( i % 7 );
+		acc += x;
+		acc /= y;
+		acc %= natural( 13 );
+		assert( acc == natural( ( ( i * 977 + i % 7 + i ) / 977 ) % 13 ) );
+	}
+	natural big = natural( 1 << 28 ).power( 4 );		// 112 bits
+	assert( big / natural( 1 << 28 ) == natural( 1 << 28 ).power( 3 ) );
+	assert( digit_buffer::heap_allocs == allocs );
+
+	big *= big;
+	assert( digit_buffer::heap_allocs > allocs );
+	assert( big % natural( 1 << 30 ) == natural( 0 ) );
+}
+
+natural factorial( int n ) {
+	natural res( 1 );
+	for ( int i = 2; i <= n; ++i ) res *= natural( i );
+	return res;
+}
+
+void test_arena() {
+	std::cout << "TEST ARENA" << std::endl;
+	std::vector<natural> expected, results( 5 );
+	for ( int job = 0; job < 5; ++job ) {
+		expected.push_back( factorial( 40 + job ) / factorial( 20 ) % natural( 1e30 ) );
+	}
+	{
+		natural_arena arena;
+		for ( int job = 0; job < 5; ++job ) {
+			natural r = factorial( 40 + job ) / factorial( 20 ) % natural( 1e30 );
+			assert( r._digits._res == &arena._arena );
+			results[ job ] = r;
+			arena.reset();
+		}
+	}
+	assert( results == expected );
+	natural after = factorial( 30 );
+	assert( after._digits._res == std::pmr::get_default_resource() );
+}
+
+void test_pow_mod() {
+	std::cout << "TEST POW MOD" << std::endl;
+	assert( pow_mod( natural( 7 ), natural( 560 ), natural( 561 ) ) == natural( 1 ) );
+	for ( int b = 0; b < 40; b += 3 ) {
+		for ( int e = 0; e < 70; e += 7 ) {
+			for ( int m : { 1, 2, 97, 256, 1000, 65535, 65536, 1234567 } ) {
+				assert( pow_mod( natural( b ), natural( e ), natural( m ) ) == 
+						natural( b ).power( e ) % natural( m ) );
+			}
+		}
+	}
+
+	natural p = natural( 2 ).power( 127 ) - natural( 1 );		// Mersenne prime
+	natural a = natural( 2 ).power( 100 ) + natural( 12345 );
+	assert( pow_mod( a, p - natural( 1 ), p ) == natural( 1 ) );
+	assert( pow_mod( a, p, p ) == a );
+	natural even = natural( 2 ).power( 90 ) * natural( 3 );
+	assert( pow_mod( a, natural( 1000 ), even ) == 
+			pow_mod( pow_mod( a, natural( 10 ), even ), natural( 100 ), even ) );
+}
+
+natural random_natural( std::mt19937 &gen, std::size_t bits ) {
+	natural res;
+	res._digits.resize( bits / 8 );
+	for ( auto &d : res._digits ) d = gen() & 255;
+	res[ res.digit_count() - 1 ] |= 128;
+	return res;
+}
+
+void bench_pow_mod() {
+	std::mt19937 gen( 42 );
+	for ( std::size_t bits : { 1024, 2048, 4096 } ) {
+		natural base = random_natural( gen, bits ), exp = random_natural( gen, bits ),
+				mod = random_natural( gen, bits );
+		mod[0] |= 1;
+		auto start = std::chrono::steady_clock::now();
+		natural res = pow_mod( base, exp, mod );
+		std::chrono::duration<double> took = std::chrono::steady_clock::now() - start;
+		std::cout << bits << " bits: " << took.count() << " s" << std::endl;
+	}
+}
+
+void test_parallel() {
+	std::cout << "TEST PARALLEL" << std::endl;
+	std::mt19937 gen( 7 );
+	std::size_t grain = task_pool::min_grain, threshold = karatsuba_threshold;
+	task_pool::min_grain = 64;
+	for ( std::size_t bits : { 8, 256, 800, 2048, 6000 } ) {
+		for ( std::size_t other : { 8, 512, 3000, 8000 } ) {
+			natural a = random_natural( gen, bits ), b = random_natural( gen, other );
+			natural fast = a * b;
+			karatsuba_threshold = std::size_t( -1 );
+			natural slow = a * b;
+			karatsuba_threshold = threshold;
+			assert( fast == slow );
+			assert( karatsuba( a, a ) == a * a );
+			assert( fast / a == b && fast % b == natural( 0 ) );
+		}
+	}
+
+	natural x = random_natural( gen, 4000 );
+	std::vector<natural> expected;
+	for ( natural y = x; y != natural( 0 ); y /= natural( 10 ) ) expected.push_back( y % natural( 10 ) );
+	std::reverse( expected.begin(), expected.end() );
+	assert( x.digits( 10 ) == expected );
+	assert( x.digits( natural( 2 ).power( 64 ) ).size() == ( 4000 + 63 ) / 64 );
+	task_pool::min_grain = grain;
+}
+
+void bench_parallel() {
+	std::mt19937 gen( 42 );
+	for ( std::size_t bits : { 1 << 12, 1 << 14, 1 << 16 } ) {
+		natural a = random_natural( gen, bits ), b = random_natural( gen, bits );
+		auto start = std::chrono::steady_clock::now();
+		natural c = a * b;
+		std::chrono::duration<double> mul = std::chrono::steady_clock::now() - start;
+		start = std::chrono::steady_clock::now();
+		auto digits = c.digits( 10 );
+		std::chrono::duration<double> conv = std::chrono::steady_clock::now() - start;
+		std::cout << bits << " bits: multiply " << mul.count() << " s, "
+				  << digits.size() << " decimal digits " << conv.count() << " s" << std::endl;
+	}
+}
+
+//	a number of the given digits, each equal to d
+natural repeated( std::size_t count, std::uint8_t d ) {
+	natural res;
+	res._digits.resize( 0 );
+	res._digits.resize( count, d );
+	res.remove_zero_digits();
+	return res;
+}
+
+void test_kernels() {
+	std::cout << "TEST KERNELS" << std::endl;
+	std::mt19937 gen( 11 );
+	for ( std::size_t len : { 1, 7, 8, 9, 16, 17, 33, 100 } ) {
+		natural ones = repeated( len, 255 );
+		natural next = ones + natural( 1 );
+		assert( next == natural( 256 ).power( len ) );
+		assert( next - natural( 1 ) == ones );
+		assert( next - ones == natural( 1 ) );
+		assert( ones < next && next > ones && !( next < ones ) && ones <= ones && ones >= ones );
+
+		for ( int i = 0; i < 20; ++i ) {
+			natural a = random_natural( gen, len * 8 ), b = random_natural( gen, len * 8 );
+			std::vector< std::uint8_t > ra( a._digits.rbegin(), a._digits.rend() ),
+										rb( b._digits.rbegin(), b._digits.rend() );
+			assert( ( a < b ) == ( ra < rb ) );
+			assert( ( a == b ) == ( ra == rb ) );
+			natural sum = a + b;
+			assert( sum - a == b && sum - b == a );
+			natural big = a < b ? b : a, small = a < b ? a : b;
+			natural diff = big;
+			diff -= small;
+			assert( diff + small == big );
+			b[0] = a[0] ^ 1;		// differ in the lowest digit only
+			for ( std::size_t j = 1; j < len; ++j ) b[j] = a[j];
+			b.remove_zero_digits();
+			assert( a != b && ( a < b ) == ( a[0] < b[0] ) && compare( a, a ) == 0 );
+		}
+	}
+}
+
+/* Random operands against adversarial ones: for comparison, those that
+ * differ in the top digit (an early exit would stop at once) and in the
+ * lowest one; for addition, 11…1 + 1 where the carry ripples through
+ * all the digits. */
+
+void bench_kernels() {
+	std::mt19937 gen( 42 );
+	auto time = []( auto fn ) {
+		auto start = std::chrono::steady_clock::now();
+		fn();
+		std::chrono::duration<double> took = std::chrono::steady_clock::now() - start;
+		return took.count();
+	};
+	for ( std::size_t len : { 64, 1024, 16384 } ) {
+		natural a = random_natural( gen, len * 8 ), b = random_natural( gen, len * 8 ),
+				top = a, low = a, ones = repeated( len, 255 ), one( 1 );
+		top[ len - 1 ] ^= 1;
+		low[0] ^= 1;
+		std::size_t reps = ( 1 << 24 ) / len, count = 0;
+		double cmp_rand = time( [&] { for ( std::size_t i = 0; i < reps; ++i ) { a[0] ^= 2; count += a < b; } } );
+		double cmp_top = time( [&] { for ( std::size_t i = 0; i < reps; ++i ) { a[0] ^= 2; count += a < top; } } );
+		double cmp_low = time( [&] { for ( std::size_t i = 0; i < reps; ++i ) { a[0] ^= 2; count += a < low; } } );
+		natural acc = a;
+		double add_rand = time( [&] { for ( std::size_t i = 0; i < reps; ++i ) { acc += b; acc -= b; } } );
+		acc = ones;
+		double add_carry = time( [&] { for ( std::size_t i = 0; i < reps; ++i ) { acc += one; acc -= one; } } );
+		std::cout << len << " digits, " << reps << " reps: compare " << cmp_rand << " / " 
+				  << cmp_top << " / " << cmp_low << " s, add+sub " << add_rand << " / " 
+				  << add_carry << " s, " << count << " compares true" << std::endl;
+	}
+}
+
+void test_shifts() {
+	std::cout << "TEST SHIFTS" << std::endl;
+	std::mt19937 gen( 13 );
+	for ( std::size_t bits : { 8, 24, 64, 200 } ) {
+		natural n = random_natural( gen, bits );
+		for ( std::size_t sh : { 0, 1, 7, 8, 9, 15, 16, 63, 64, 65, 130, 300 } ) {
+			natural scale = natural( 2 ).power( sh );
+			assert( ( n << sh ) == n * scale );
+			assert( ( n >> sh ) == n / scale );
+			assert( ( ( n << sh ) >> sh ) == n );
+			natural m = n;
+			m <<= sh;
+			m >>= sh + 3;
+			assert( m == n / natural( 8 ) );
+
+			natural big = ( n << sh ) + natural( 12345 ), rest = big;
+			assert( sub_shifted( rest, n, sh ) && rest == natural( 12345 ) );
+			rest = big;
+			bool fits = ( n << ( sh + 1 ) ) <= big;
+			assert( sub_shifted( rest, n, sh + 1 ) == fits );
+			assert( rest == ( fits ? big - ( n << ( sh + 1 ) ) : big ) );
+			assert( !sub_shifted( rest = n, n, 1 ) && rest == n );
+		}
+	}
+	assert( ( natural( 0 ) << 100 ) == natural( 0 ) && ( natural( 5 ) >> 100 ) == natural( 0 ) );
+	natural zero( 0 );
+	assert( sub_shifted( zero, natural( 0 ), 9 ) && zero == natural( 0 ) );
+}
+
 int main()
 {
     natural m( 2.1 ), n( 2.9 );
@@ -345,6 +1318,16 @@ int main()
 	test_division();
     test_digits();
     test_double();
+    test_compound();
+    test_small();
+    test_arena();
+    test_pow_mod();
+    test_parallel();
+    test_kernels();
+    test_shifts();
+    //bench_pow_mod();
+    //bench_parallel();
+    //bench_kernels();
 
     return 0;
 }
\ No newline at end of file
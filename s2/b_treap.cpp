@@ -4,6 +4,23 @@
 #include <random>
 #include <queue>
 #include <iostream>
+#include <cstdint>
+#include <chrono>
+#include <set>
+#include <future>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <array>
+#include <concepts>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <memory_resource>
+#include <bit>
+#include <iterator>
+#include <span>
 
 /* Datová struktura «treap» kombinuje binární vyhledávací strom a
  * binární haldu – hodnotu, vůči které tvoří vyhledávací strom
@@ -63,162 +80,352 @@
  * zachovat vazbu mezi klíči a prioritami (tzn. může přesunout klíč
  * do jiného uzlu aniž by zároveň přesunula prioritu). */
 
-struct treap;
-
 /* ¹ Verze s přesunem můžete volitelně vynechat (v takovém případě
  *   je označte jako smazané). Budou-li přítomny, budou testovány.
  *   Implementace přesunu je podmínkou hodnocení kvality známkou A. */
 
-struct node {
-	int _key;
+/* Nodes live in a single pool owned by the treap and refer to each
+ * other by 32-bit indices into it. Slot 0 is never used, so index 0
+ * stands for «no node», and slots of erased nodes are kept on a free
+ * list (linked through ‹_left›) for reuse. Compared to separately
+ * allocated nodes linked by pointers, the nodes are smaller and close
+ * to each other, and ‹clear› simply forgets the whole pool at once.
+ *
+ * The pool may be reallocated by an insertion, hence the nodes handed
+ * out through ‹root›, ‹left› and ‹right› are only valid until the next
+ * modification of the treap. To find its neighbours in the pool, each
+ * node knows its own index. */
+
+template< typename Key >
+struct basic_node {
+	using index = std::uint32_t;
+
+	Key _key;
 	int _priority;
-	node *parent;
-	std::unique_ptr<node> _left = nullptr;
-	std::unique_ptr<node> _right = nullptr;
+	index _self;
+	index _parent = 0;
+	index _left = 0;
+	index _right = 0;
+	index _size = 1;		// of the subtree rooted here
 
-	node( int k, int p, node *par ) : _key(k), _priority(p), parent( par ) {}
+	basic_node( Key k, int p, index self, index par ) 
+		: _key( std::move( k ) ), _priority(p), _self( self ), _parent( par ) {}
 
-	node *left() const   { return _left.get(); }
-	node *right() const  { return _right.get(); }
-	int key() const 	   { return _key; }
+	const basic_node *at( index i ) const { return i ? this - _self + i : nullptr; }
+	const basic_node *left() const   { return at( _left ); }
+	const basic_node *right() const  { return at( _right ); }
+	const Key &key() const 	   { return _key; }
 	int priority() const { return _priority; }
 
-	node *add_node( int k, int p ) {
-		if ( k < _key ) {
-			_left = std::make_unique<node>( k, p, this );
-			return _left.get();
-		} else {
-			_right = std::make_unique<node>( k, p, this );
-			return _right.get();
-		}
+	std::size_t count() const { return _size; }
+
+	void print() const {
+		std::cout << "( k: " << _key << ", p: " << _priority << ", children: ";
+		if ( left() )  std::cout << "l ";
+		if ( right() ) std::cout << "r ";
+		std::cout << ") ";
 	}
+};
 
-	std::size_t count() const {
-		std::size_t n_count = 1;
-		if ( left() )  n_count += left()->count();
-		if ( right() ) n_count += right()->count();
-		return n_count;
+using node = basic_node< int >;
+
+//	default priorities: a xorshift generator, seedable per treap and much
+//	cheaper than ‹rand()›; yields non-negative ‹int› values like ‹rand()›
+struct priority_source {
+	std::uint64_t _state;
+
+	explicit priority_source( std::uint64_t seed ) : _state( seed ? seed : 1 ) {}
+	int operator()() {
+		_state ^= _state << 13;
+		_state ^= _state >> 7;
+		_state ^= _state << 17;
+		return static_cast< int >( _state >> 33 );
 	}
+};
 
-	void copy( std::vector<int> &vec ) const {
-		if ( left() ) left()->copy( vec );
-		vec.push_back( _key );
-		if ( right() ) right()->copy( vec );
+//	lookups by a type other than the key need a transparent comparison
+template< typename Compare >
+concept transparent = requires { typename Compare::is_transparent; };
+
+/* A read-only copy of a treap for lookup-heavy workloads, made by
+ * ‹freeze›. The keys form a complete binary search tree stored in
+ * breadth-first ( Eytzinger ) order: the children of position i are
+ * at 2i and 2i + 1, so there are no links to follow and the top levels
+ * shared by all searches stay in the cache. The descent has no
+ * data-dependent branch and prefetches the line holding the
+ * descendants a few levels below the current position, hiding most of
+ * the latency of the misses further down. */
+
+template< typename Key, typename Compare = std::less< Key > >
+struct frozen_set {
+	static constexpr std::size_t prefetch_ahead = 
+		std::max< std::size_t >( 1, 64 / sizeof( Key ) );	// descendants sharing a cache line
+
+	std::vector< Key > _keys;		// position 0 is unused
+	[[no_unique_address]] Compare _less;
+
+	frozen_set( const std::vector< Key > &sorted, const Compare &less ) 
+		: _keys( sorted.size() + 1 ), _less( less ) {
+		std::size_t next = 0;
+		fill( sorted, next, 1 );
 	}
 
-	std::unique_ptr<node> duplicate( node *par_dupl ) {
-		auto n = std::make_unique<node>( key(), priority(), par_dupl );
-		if ( left() )  n->_left  = right()->duplicate( this );
-		if ( right() ) n->_right = right()->duplicate( this );
-		return n;
+	//	an in-order walk of the implicit tree takes the keys in sorted order
+	void fill( const std::vector< Key > &sorted, std::size_t &next, std::size_t i ) {
+		if ( i >= _keys.size() ) return;
+		fill( sorted, next, 2 * i );
+		_keys[i] = sorted[ next++ ];
+		fill( sorted, next, 2 * i + 1 );
 	}
 
-	void print() const {
-		std::cout << "( k: " << _key << ", p: " << _priority << ", children: ";
-		if ( left() )  std::cout << "l ";
-		if ( right() ) std::cout << "r ";
-		std::cout << ") ";
+	std::size_t size() const { return _keys.size() - 1; }
+
+	bool contains( const Key &k ) const { return contains_of( k ); }
+	template< typename K > requires transparent< Compare >
+	bool contains( const K &k ) const { return contains_of( k ); }
+
+	template< typename K >
+	bool contains_of( const K &k ) const {
+		std::size_t i = 1, n = _keys.size();
+		while ( i < n ) {
+#if defined( __GNUC__ )
+			__builtin_prefetch( _keys.data() + std::min( prefetch_ahead * i, n - 1 ) );
+#endif
+			i = 2 * i + _less( _keys[i], k );
+		}
+		i >>= std::countr_one( i ) + 1;		// undo the right turns after the last left one
+		return i && !_less( k, _keys[i] );
 	}
 };
 
-struct treap {
-	std::unique_ptr<node> _root = nullptr;
+/* The threads the bulk operations of all treaps ( of any key type ) may
+ * fork at once, beside the ones which called them, and those running. */
+
+struct fork_budget {
+	static inline unsigned max_forks = std::max( 1u, std::thread::hardware_concurrency() ) - 1;
+	static inline std::atomic< unsigned > active_forks = 0;
 
-	treap() = default;
-	treap( treap &&other ) {
-		_root = std::move( other._root );		
+	//	takes one of the fork slots, if there is one free
+	static bool reserve() {
+		unsigned active = active_forks.load();
+		while ( active < max_forks ) {
+			if ( active_forks.compare_exchange_weak( active, active + 1 ) ) return true;
+		}
+		return false;
 	}
-	treap( const treap &other ) {
-		if ( other.root() ) _root = other.root()->duplicate( nullptr );
-	};
-	treap &operator=( treap &&other ) {
-		_root = std::move( other._root );
+};
+
+/* The treap over any ‹Key› ordered by ‹Compare› ( with keys
+ * equivalent when neither is less than the other ), storing its
+ * nodes through ‹Alloc› rebound to the node type. Lookups accept any
+ * type comparable with the keys when ‹Compare› is transparent, e.g.
+ * ‹std::string_view› for a treap of ‹std::string› with ‹std::less<>›.
+ * ‹Key› must be default constructible for the null node. */
+
+template< typename Key, typename Compare = std::less< Key >, typename Alloc = std::allocator< Key > >
+struct basic_treap {
+	using node = basic_node< Key >;
+	using index = typename node::index;
+	using node_alloc = typename std::allocator_traits< Alloc >::template rebind_alloc< node >;
+	static constexpr std::uint64_t default_seed = 0x2545f4914f6cdd1d;
+
+	std::vector< node, node_alloc > _pool;		// slot 0 is the null node
+	index _root = 0;
+	index _free = 0;
+	[[no_unique_address]] Compare _less;
+	priority_source _priorities;
+
+	basic_treap() : basic_treap( default_seed ) {}
+	explicit basic_treap( std::uint64_t seed, const Compare &less = Compare(),
+						  const Alloc &alloc = Alloc() )
+		: _pool( node_alloc( alloc ) ), _less( less ), _priorities( seed ) {
+		reset();
+	}
+	basic_treap( const basic_treap &other )
+		: _pool( std::allocator_traits< node_alloc >::select_on_container_copy_construction(
+					 other._pool.get_allocator() ) ),
+		  _less( other._less ), _priorities( other._priorities ) {
+		deep_copy( other );
+	}
+	basic_treap( basic_treap &&other ) 
+		: _pool( std::move( other._pool ) ), _root( other._root ), _free( other._free ),
+		  _less( other._less ), _priorities( other._priorities ) {
+		other.reset();
+	}
+	basic_treap &operator=( const basic_treap &other ) {
+		if ( this == &other ) return *this;
+		_less = other._less;
+		_priorities = other._priorities;
+		deep_copy( other );
 		return *this;
 	}
-	treap &operator=( const treap &other ) {
-		if ( other.root() ) _root = other.root()->duplicate( nullptr );
+	basic_treap &operator=( basic_treap &&other ) {
+		if ( this == &other ) return *this;
+		_pool = std::move( other._pool );
+		_root = other._root;
+		_free = other._free;
+		_less = other._less;
+		_priorities = other._priorities;
+		other.reset();
 		return *this;
 	}
-	
+
+	template< typename A, typename B >
+	bool equal( const A &a, const B &b ) const { return !_less( a, b ) && !_less( b, a ); }
+
+	//	leaves the pool with just the null node, keeping its capacity
+	void reset() {
+		_pool.clear();
+		_pool.emplace_back( Key(), 0, 0, 0 );
+		_root = _free = 0;
+	}
+
+	/* A pool without free slots is copied as a whole. Otherwise only
+	 * the nodes in use are copied, in preorder, into a pool allocated
+	 * up front – the free slots of other are dropped and a parent ends
+	 * up next to its left child. An explicit stack replaces recursion,
+	 * so a degenerate ( deep ) tree cannot overflow the call stack. */
+	void deep_copy( const basic_treap &other ) {
+		if ( !other._free ) {
+			_pool = other._pool;
+			_root = other._root;
+			_free = 0;
+			return;
+		}
+		reset();
+		_pool.reserve( other.size() + 1 );
+		std::vector< std::pair< index, index > > todo;		// node of other, parent here
+		if ( other._root ) todo.emplace_back( other._root, 0 );
+		while ( !todo.empty() ) {
+			auto [ from, parent ] = todo.back();
+			todo.pop_back();
+			const node &src = other.at( from );
+			index i = _pool.size();
+			_pool.push_back( src );
+			node &n = at( i );
+			n._self = i;
+			n._parent = parent;
+			n._left = n._right = 0;
+			if ( !parent ) _root = i;
+			else ( _less( src.key(), at( parent ).key() ) ? at( parent )._left : at( parent )._right ) = i;
+			if ( src._right ) todo.emplace_back( src._right, i );
+			if ( src._left ) todo.emplace_back( src._left, i );
+		}
+	}
+
+	node &at( index i ) { return _pool[i]; }
+	const node &at( index i ) const { return _pool[i]; }
+
+	index make_node( Key k, int p, index par ) {
+		if ( !_free ) {
+			index i = _pool.size();
+			_pool.emplace_back( std::move( k ), p, i, par );
+			return i;
+		}
+		index i = _free;
+		_free = at( i )._left;
+		at( i ) = node( std::move( k ), p, i, par );
+		return i;
+	}
+	void free_node( index i ) {
+		at( i )._left = _free;
+		_free = i;
+	}
+
+	index size_of( index n ) const { return n ? at( n )._size : 0; }
+	void update_size( index n ) {
+		at( n )._size = 1 + size_of( at( n )._left ) + size_of( at( n )._right );
+	}
+
+	//	the link ( in the parent or the root ) which points to n
+	index &link_to( index n ) {
+		index p = at( n )._parent;
+		if ( !p ) return _root;
+		return ( at( p )._left == n ) ? at( p )._left : at( p )._right;
+	}
 
 	// rOTat e ba nAn a
-	node *rotate( node *n ) {
-		node *p = n->parent;
-		if ( !p || p->priority() >= n->priority() ) return nullptr;
-		
-		std::unique_ptr<node> &transfer_child = ( n->key() < p->key() ) ? n->_right : n->_left;
-		std::unique_ptr<node> &n_ptr = 			( n->key() < p->key() ) ? p->_left : p->_right;
-		std::unique_ptr<node> &p_ptr = 			( !p->parent ) ? _root : 
-					 		 ( ( p->key() < p->parent->key() ) ? p->parent->_left : p->parent->_right );
-
-		if ( transfer_child ) transfer_child->parent = p_ptr.get();
-		n_ptr->parent = p_ptr->parent;
-		p_ptr->parent = n_ptr.get();
-		
-		std::unique_ptr<node> temp = std::move( transfer_child );
-		transfer_child = std::move( p_ptr );
-		p_ptr = std::move( n_ptr );
-		n_ptr = std::move( temp );
-		return p_ptr.get();
+	index rotate( index n ) {
+		index p = at( n )._parent;
+		if ( !p || at( p ).priority() >= at( n ).priority() ) return 0;
+
+		bool from_left = at( p )._left == n;
+		index &p_link = link_to( p );
+		index moved = from_left ? at( n )._right : at( n )._left;
+
+		p_link = n;
+		at( n )._parent = at( p )._parent;
+		( from_left ? at( n )._right : at( n )._left ) = p;
+		at( p )._parent = n;
+		( from_left ? at( p )._left : at( p )._right ) = moved;
+		if ( moved ) at( moved )._parent = p;
+		at( n )._size = at( p )._size;
+		update_size( p );
+		return n;
 	}
 	
-	node *root() const { return _root.get(); }
+	const node *root() const { return _root ? &at( _root ) : nullptr; }
 
 	//	finds the node with key closest to k that has 1 or 0 children
-	node *find_key( int k ) const {
-		if ( !root() ) return nullptr;
-		node *current = root();
-		while( k != current->key() ) {
-			if ( k < current->key() && current->left() ) {
-				current = current->left();
-			} else if ( k > current->key() && current->right() ) {
-				current = current->right();
-			} else {
-				return current;
-			}
+	template< typename K >
+	index find_key( const K &k ) const {
+		index current = _root;
+		while( current ) {
+			index next;
+			if ( _less( k, at( current ).key() ) ) next = at( current )._left;
+			else if ( _less( at( current ).key(), k ) ) next = at( current )._right;
+			else return current;
+			if ( !next ) return current;
+			current = next;
 		}
 		return current;
 	}
-	
-	bool insert( int k, int p = rand() ) {
-		if ( !root() ) {
-			_root = std::make_unique<node>( k, p, nullptr );
+	template< typename K >
+	index find( const K &k ) const {
+		index n = find_key( k );
+		return ( n && equal( at( n ).key(), k ) ) ? n : 0;
+	}
+
+	bool insert( const Key &k ) { return insert( k, _priorities() ); }
+	bool insert( const Key &k, int p ) {
+		if ( !_root ) {
+			_root = make_node( k, p, 0 );
 			return true;
 		}
-		node *n = find_key( k );
-		if ( n->key() == k ) return false;
-		node *new_node = n->add_node( k, p ); 
-		new_node = rotate( new_node );
-		while( new_node ) {
-			new_node = rotate( new_node );
-		}
+		index n = find_key( k );
+		if ( equal( at( n ).key(), k ) ) return false;
+		bool to_left = _less( k, at( n ).key() );
+		index new_node = make_node( k, p, n );
+		( to_left ? at( n )._left : at( n )._right ) = new_node;
+		for ( index up = n; up; up = at( up )._parent ) ++at( up )._size;
+		while( rotate( new_node ) ) {}
 		return true;
 	}
 
 	//	deletes node with 1 or 0 children 
-	//	and transfers the child pointer ( or nullptr ) to the parent
-	node *delete_node( node *n ) {
-		node *p = n->parent;
-
-		std::unique_ptr<node> &child = ( n->left() ) ? n->_left : n->_right;
-		if ( child ) child->parent = p;
-		if ( !p ) {
-			_root = (child) ? std::move( child ) : nullptr;
-		} else {
-			std::unique_ptr<node> &n_ptr = ( n->key() < p->key() ) ? p->_left : p->_right;
-			n_ptr = (child) ? std::move( child ) : nullptr;
-		}
+	//	and transfers the child index ( or 0 ) to the parent
+	index delete_node( index n ) {
+		index p = at( n )._parent;
+		index child = at( n )._left ? at( n )._left : at( n )._right;
+		if ( child ) at( child )._parent = p;
+		link_to( n ) = child;
+		free_node( n );
+		for ( index up = p; up; up = at( up )._parent ) --at( up )._size;
 		return p;
 	}
 	
-	bool erase( int k ) {
-		node *n = find_key( k );
-		if ( !n || n->key() != k ) return false;
+	bool erase( const Key &k ) { return erase_node( find( k ) ); }
+	template< typename K > requires transparent< Compare >
+	bool erase( const K &k ) { return erase_node( find( k ) ); }
+
+	//	removes the key in n, if there is a node
+	bool erase_node( index n ) {
+		if ( !n ) return false;
 		
-		if ( n->left() && n->right() ) {	// node is inner with two children
-			node *succ = n->right(); 	// = find_key(k+1);
-			while( succ->left() ) { succ = succ->left(); }
-			n->_key = succ->key();
+		if ( at( n )._left && at( n )._right ) {	// node is inner with two children
+			index succ = at( n )._right; 	// = find_key(k+1);
+			while( at( succ )._left ) { succ = at( succ )._left; }
+			at( n )._key = std::move( at( succ )._key );
 			delete_node( succ );
 		} else {
 			delete_node( n );			
@@ -226,34 +433,490 @@ struct treap {
 		return true;
 	}
 
-	bool contains( int k ) const {
-		node *n = find_key( k );
-		return ( n && n->key() == k );
+	// ================ SPLIT / MERGE
+
+	/* The bulk operations restructure the tree by splitting and
+	 * joining subtrees within the pool, ‹attach› restores the parent
+	 * links and the size of a node whose children changed. The set
+	 * operations first copy the nodes of the other treap into this
+	 * pool (‹import›) and then recurse over both trees; above
+	 * ‹parallel_grain› nodes the two halves are processed in parallel.
+	 * They touch disjoint nodes, so the only shared state – the free
+	 * list – is left alone until the recursion is over: the nodes to
+	 * be dropped are collected per branch and freed at the end. At most
+	 * ‹fork_budget::max_forks› branches run on threads of their own at
+	 * any time, the rest is done serially. */
+
+	static inline std::size_t parallel_grain = 1 << 14;
+
+	index attach( index n, index l, index r ) {
+		at( n )._left = l;
+		at( n )._right = r;
+		if ( l ) at( l )._parent = n;
+		if ( r ) at( r )._parent = n;
+		update_size( n );
+		return n;
 	}
-	
-	int priority( int k ) {
-		node *n = find_key( k );
-		if ( !n || n->key() != k ) return -1;
-		return n->priority();
+	index make_root( index n ) {
+		if ( n ) at( n )._parent = 0;
+		return n;
+	}
+
+	//	splits n into keys less than k, the node with key k ( or 0 ) and greater keys
+	void split_at( index n, const Key &k, index &less, index &equal, index &greater ) {
+		if ( !n ) {
+			less = equal = greater = 0;
+		} else if ( this->equal( at( n ).key(), k ) ) {
+			less = make_root( at( n )._left );
+			greater = make_root( at( n )._right );
+			equal = attach( n, 0, 0 );
+		} else if ( _less( at( n ).key(), k ) ) {
+			split_at( at( n )._right, k, less, equal, greater );
+			less = attach( n, at( n )._left, less );
+			make_root( greater );
+		} else {
+			split_at( at( n )._left, k, less, equal, greater );
+			greater = attach( n, greater, at( n )._right );
+			make_root( less );
+		}
+	}
+
+	//	all keys in l must be less than those in r
+	index join( index l, index r ) {
+		if ( !l || !r ) return make_root( l ? l : r );
+		if ( at( l ).priority() >= at( r ).priority() ) {
+			return attach( l, at( l )._left, join( at( l )._right, r ) );
+		}
+		return attach( r, join( l, at( r )._left ), at( r )._right );
+	}
+
+	//	collects all nodes of the subtree without recursion
+	void drop_subtree( index n, std::vector<index> &dropped ) const {
+		std::size_t from = dropped.size();
+		if ( n ) dropped.push_back( n );
+		for ( std::size_t i = from; i < dropped.size(); ++i ) {
+			for ( index c : { at( dropped[i] )._left, at( dropped[i] )._right } ) {
+				if ( c ) dropped.push_back( c );
+			}
+		}
+	}
+	void free_nodes( const std::vector<index> &dropped ) {
+		for ( index n : dropped ) free_node( n );
+	}
+
+	//	appends the pool of other ( including its free slots ) to this one,
+	//	returns the new index of its root
+	index import( const basic_treap &other ) {
+		index off = _pool.size() - 1;
+		auto shift = [ off ]( index i ) { return i ? i + off : 0; };
+		_pool.insert( _pool.end(), other._pool.begin() + 1, other._pool.end() );
+		for ( index i = off + 1; i < _pool.size(); ++i ) {
+			node &n = at( i );
+			n._self = i;
+			n._parent = shift( n._parent );
+			n._left = shift( n._left );
+			n._right = shift( n._right );
+		}
+		for ( index f = shift( other._free ); f; f = at( f )._left ) {	// splice the free lists
+			if ( !at( f )._left ) {
+				at( f )._left = _free;
+				_free = shift( other._free );
+				break;
+			}
+		}
+		return shift( other._root );
+	}
+
+	using set_op = index ( basic_treap::* )( index, index, std::vector<index> & );
+
+	//	applies op to ( a1, b1 ) and ( a2, b2 ), in parallel if both are big enough
+	//	and a fork slot is free – the work of a set operation is bounded by its
+	//	smaller operand
+	std::pair<index, index> fork_join( set_op op, index a1, index b1, index a2, index b2,
+									   std::vector<index> &dropped ) {
+		auto work = [ this ]( index a, index b ) { return std::min( size_of( a ), size_of( b ) ); };
+		if ( std::min( work( a1, b1 ), work( a2, b2 ) ) < parallel_grain || !fork_budget::reserve() ) {
+			index first = ( this->*op )( a1, b1, dropped );
+			return { first, ( this->*op )( a2, b2, dropped ) };
+		}
+		std::vector<index> second_dropped;
+		auto second = std::async( std::launch::async, [ & ] { 
+			return ( this->*op )( a2, b2, second_dropped ); } );
+		index first = ( this->*op )( a1, b1, dropped );
+		index res = second.get();
+		--fork_budget::active_forks;
+		dropped.insert( dropped.end(), second_dropped.begin(), second_dropped.end() );
+		return { first, res };
+	}
+
+	index unite_at( index a, index b, std::vector<index> &dropped ) {
+		if ( !a || !b ) return make_root( a ? a : b );
+		if ( at( a ).priority() < at( b ).priority() ) std::swap( a, b );
+		index less, equal, greater;
+		split_at( b, at( a ).key(), less, equal, greater );
+		if ( equal ) dropped.push_back( equal );
+		auto [ l, r ] = fork_join( &basic_treap::unite_at, at( a )._left, less, 
+								   at( a )._right, greater, dropped );
+		return make_root( attach( a, l, r ) );
+	}
+
+	index intersect_at( index a, index b, std::vector<index> &dropped ) {
+		if ( !a || !b ) {
+			drop_subtree( a, dropped );
+			drop_subtree( b, dropped );
+			return 0;
+		}
+		if ( at( a ).priority() < at( b ).priority() ) std::swap( a, b );
+		index less, equal, greater;
+		split_at( b, at( a ).key(), less, equal, greater );
+		auto [ l, r ] = fork_join( &basic_treap::intersect_at, at( a )._left, less, 
+								   at( a )._right, greater, dropped );
+		if ( equal ) {
+			dropped.push_back( equal );
+			return make_root( attach( a, l, r ) );
+		}
+		dropped.push_back( a );
+		return join( l, r );
+	}
+
+	//	a without the keys of b
+	index subtract_at( index a, index b, std::vector<index> &dropped ) {
+		if ( !a || !b ) {
+			drop_subtree( b, dropped );
+			return make_root( a );
+		}
+		index less, equal, greater;
+		split_at( b, at( a ).key(), less, equal, greater );
+		auto [ l, r ] = fork_join( &basic_treap::subtract_at, at( a )._left, less, 
+								   at( a )._right, greater, dropped );
+		if ( equal ) {
+			dropped.push_back( equal );
+			dropped.push_back( a );
+			return join( l, r );
+		}
+		return make_root( attach( a, l, r ) );
+	}
+
+	//	unite_at where a key in both keeps the node of a, so that the keys
+	//	already present keep their priorities; a node of b above it is
+	//	dropped and the node of a joined back in between the halves
+	index unite_keep_at( index a, index b, std::vector<index> &dropped ) {
+		if ( !a || !b ) return make_root( a ? a : b );
+		bool a_top = at( a ).priority() >= at( b ).priority();
+		index top = a_top ? a : b, less, equal, greater;
+		split_at( a_top ? b : a, at( top ).key(), less, equal, greater );
+		auto [ l, r ] = a_top ? fork_join( &basic_treap::unite_keep_at, at( a )._left, less,
+										   at( a )._right, greater, dropped )
+							  : fork_join( &basic_treap::unite_keep_at, less, at( b )._left,
+										   greater, at( b )._right, dropped );
+		if ( !equal ) return make_root( attach( top, l, r ) );
+		if ( a_top ) {
+			dropped.push_back( equal );
+			return make_root( attach( a, l, r ) );
+		}
+		dropped.push_back( b );
+		return make_root( join( l, join( equal, r ) ) );
+	}
+
+	void apply( set_op op, const basic_treap &other ) {
+		if ( &other == this ) {
+			apply( op, basic_treap( other ) );
+			return;
+		}
+		index b = import( other );
+		std::vector<index> dropped;
+		_root = make_root( ( this->*op )( _root, b, dropped ) );
+		free_nodes( dropped );
+	}
+
+	basic_treap &unite( const basic_treap &other ) { apply( &basic_treap::unite_at, other ); return *this; }
+	basic_treap &intersect( const basic_treap &other ) { apply( &basic_treap::intersect_at, other ); return *this; }
+	basic_treap &subtract( const basic_treap &other ) { apply( &basic_treap::subtract_at, other ); return *this; }
+
+	//	builds a tree of strictly increasing keys in linear time and returns
+	//	its root, keeping the right spine on a stack ( a Cartesian tree )
+	template< typename iterator_t >
+	index build( iterator_t first, iterator_t last ) {
+		std::vector<index> spine;
+		index root = 0;
+		for ( auto it = first; it != last; ++it ) {
+			assert( it == first || _less( *std::prev( it ), *it ) );
+			index n = make_node( *it, _priorities(), 0 ), below = 0;
+			while ( !spine.empty() && at( spine.back() ).priority() < at( n ).priority() ) {
+				below = spine.back();
+				spine.pop_back();
+				update_size( below );		// its subtree is complete now
+			}
+			attach( n, below, 0 );
+			if ( !spine.empty() ) {
+				at( spine.back() )._right = n;
+				at( n )._parent = spine.back();
+			}
+			spine.push_back( n );
+			root = spine.front();
+		}
+		for ( ; !spine.empty(); spine.pop_back() ) update_size( spine.back() );
+		return root;
+	}
+
+	explicit basic_treap( const std::vector<Key> &sorted, std::uint64_t seed = default_seed )
+		: basic_treap( seed ) {
+		_pool.reserve( sorted.size() + 1 );
+		_root = build( sorted.begin(), sorted.end() );
+	}
+
+	/* Inserts a batch of keys at once: the batch is sorted ( unless it
+	 * already is ) and deduplicated, built into a treap of its own in
+	 * linear time and then united with this one – which descends only
+	 * into the parts of the tree where the two key sets interleave,
+	 * rather than once from the root for every key. As with ‹insert›,
+	 * the keys already present keep their nodes and priorities. Returns
+	 * the number of keys actually inserted. */
+	std::size_t insert_batch( std::span< const Key > batch ) {
+		std::vector< Key > keys( batch.begin(), batch.end() );
+		if ( !std::is_sorted( keys.begin(), keys.end(), _less ) ) {
+			std::sort( keys.begin(), keys.end(), _less );
+		}
+		auto same = [ this ]( const Key &a, const Key &b ) { return equal( a, b ); };
+		keys.erase( std::unique( keys.begin(), keys.end(), same ), keys.end() );
+		std::size_t before = size();
+		std::vector<index> dropped;
+		_root = make_root( unite_keep_at( _root, build( keys.begin(), keys.end() ), dropped ) );
+		free_nodes( dropped );
+		return size() - before;
+	}
+
+	//	moves the keys greater or equal to k into the returned treap,
+	//	in time proportional to the height and the number of moved keys
+	basic_treap split( const Key &k ) {
+		index less, equal, greater;
+		split_at( _root, k, less, equal, greater );
+		if ( equal ) greater = join( equal, greater );
+		_root = make_root( less );
+		basic_treap res( _priorities(), _less, _pool.get_allocator() );
+		std::vector<index> moved;
+		drop_subtree( greater, moved );		// breadth first, the left child first
+		res._pool.reserve( moved.size() + 1 );
+		//	the moved nodes keep that order, so the children of each one
+		//	are the next two ( or fewer ) not numbered yet
+		index next = 2;
+		for ( index n : moved ) {
+			index i = res._pool.size();
+			res._pool.push_back( at( n ) );
+			node &copy = res.at( i );
+			copy._self = i;
+			if ( copy._left ) copy._left = next++;
+			if ( copy._right ) copy._right = next++;
+		}
+		for ( index i = 1; i < res._pool.size(); ++i ) {
+			for ( index c : { res.at( i )._left, res.at( i )._right } ) if ( c ) res.at( c )._parent = i;
+		}
+		res._root = res.make_root( moved.empty() ? 0 : 1 );
+		free_nodes( moved );
+		return res;
+	}
+
+	//	appends the keys of other, which must all be greater than those here
+	void merge( const basic_treap &other ) {
+		assert( !_root || !other._root || 
+				_less( at( find_max( _root ) ).key(), other.at( other.find_min( other._root ) ).key() ) );
+		if ( &other == this ) return;		// only possible when empty
+		_root = make_root( join( _root, import( other ) ) );
+	}
+
+	index find_min( index n ) const {
+		while ( at( n )._left ) n = at( n )._left;
+		return n;
+	}
+	index find_max( index n ) const {
+		while ( at( n )._right ) n = at( n )._right;
+		return n;
 	}
+
+	//	erases the keys in [ from, to ) and returns their count
+	std::size_t erase( const Key &from, const Key &to ) {
+		if ( !_less( from, to ) ) return 0;
+		index less, equal, greater, mid_less, mid_equal, mid;
+		split_at( _root, from, less, equal, greater );
+		split_at( join( equal, greater ), to, mid_less, mid_equal, mid );
+		std::vector<index> dropped;
+		drop_subtree( mid_less, dropped );
+		_root = make_root( join( less, join( mid_equal, mid ) ) );
+		free_nodes( dropped );
+		return dropped.size();
+	}
+
+	bool contains( const Key &k ) const { return find( k ); }
+	template< typename K > requires transparent< Compare >
+	bool contains( const K &k ) const { return find( k ); }
 	
-	void clear() { _root = nullptr; }
+	int priority( const Key &k ) const { return priority_of( find( k ) ); }
+	template< typename K > requires transparent< Compare >
+	int priority( const K &k ) const { return priority_of( find( k ) ); }
+	int priority_of( index n ) const { return n ? at( n ).priority() : -1; }
 	
-	std::size_t size() const {
-		if ( !root() ) return 0;
-		return root()->count();
+	void clear() { reset(); }
+	
+	std::size_t size() const { return size_of( _root ); }
+
+	// ================ ITERATORS
+
+	/* Bidirectional iterators over the keys in ascending order. They
+	 * move along the parent links – stepping over all n keys visits
+	 * each link twice, so a scan of k consecutive keys costs O(log n + k)
+	 * and allocates nothing. The end iterator holds the null index.
+	 * Like the nodes, iterators are invalidated by any modification. */
+
+	//	the node with the next greater ( smaller ) key, or 0
+	index next( index n ) const {
+		if ( at( n )._right ) return find_min( at( n )._right );
+		while ( at( n )._parent && at( at( n )._parent )._right == n ) n = at( n )._parent;
+		return at( n )._parent;
+	}
+	index prev( index n ) const {
+		if ( at( n )._left ) return find_max( at( n )._left );
+		while ( at( n )._parent && at( at( n )._parent )._left == n ) n = at( n )._parent;
+		return at( n )._parent;
+	}
+
+	struct const_iterator {
+		using iterator_category = std::bidirectional_iterator_tag;
+		using value_type = Key;
+		using difference_type = std::ptrdiff_t;
+		using pointer = const Key *;
+		using reference = const Key &;
+
+		const basic_treap *_treap = nullptr;
+		index _n = 0;
+
+		reference operator*() const { return _treap->at( _n ).key(); }
+		pointer operator->() const { return &**this; }
+		const_iterator &operator++() { 
+			_n = _treap->next( _n ); 
+			return *this; 
+		}
+		const_iterator &operator--() {
+			_n = _n ? _treap->prev( _n ) : _treap->find_max( _treap->_root );
+			return *this;
+		}
+		const_iterator operator++( int ) { auto old = *this; ++*this; return old; }
+		const_iterator operator--( int ) { auto old = *this; --*this; return old; }
+		bool operator==( const const_iterator &other ) const = default;
+	};
+	using iterator = const_iterator;
+
+	const_iterator begin() const { return { this, _root ? find_min( _root ) : 0 }; }
+	const_iterator end() const { return { this, 0 }; }
+
+	//	the first key not less than ( greater than ) k
+	const_iterator lower_bound( const Key &k ) const { return lower_bound_of( k ); }
+	template< typename K > requires transparent< Compare >
+	const_iterator lower_bound( const K &k ) const { return lower_bound_of( k ); }
+	const_iterator upper_bound( const Key &k ) const { return upper_bound_of( k ); }
+	template< typename K > requires transparent< Compare >
+	const_iterator upper_bound( const K &k ) const { return upper_bound_of( k ); }
+
+	template< typename K >
+	const_iterator lower_bound_of( const K &k ) const {
+		index found = 0;
+		for ( index n = _root; n; ) {
+			if ( _less( at( n ).key(), k ) ) {
+				n = at( n )._right;
+			} else {
+				found = n;
+				n = at( n )._left;
+			}
+		}
+		return { this, found };
+	}
+	template< typename K >
+	const_iterator upper_bound_of( const K &k ) const {
+		index found = 0;
+		for ( index n = _root; n; ) {
+			if ( _less( k, at( n ).key() ) ) {
+				found = n;
+				n = at( n )._left;
+			} else {
+				n = at( n )._right;
+			}
+		}
+		return { this, found };
+	}
+
+	struct range_view {
+		const_iterator _begin, _end;
+		const_iterator begin() const { return _begin; }
+		const_iterator end() const { return _end; }
+	};
+
+	//	the keys in [ lo, hi ), found lazily while iterating
+	range_view range( const Key &lo, const Key &hi ) const { return range_of( lo, hi ); }
+	template< typename K > requires transparent< Compare >
+	range_view range( const K &lo, const K &hi ) const { return range_of( lo, hi ); }
+
+	template< typename K >
+	range_view range_of( const K &lo, const K &hi ) const {
+		if ( !_less( lo, hi ) ) return { end(), end() };
+		return { lower_bound_of( lo ), lower_bound_of( hi ) };
+	}
+
+	frozen_set< Key, Compare > freeze() const {
+		std::vector< Key > sorted;
+		copy( sorted );
+		return { sorted, _less };
+	}
+
+	//	the k-th smallest key ( counted from 0, k must be less than size() )
+	const Key &kth( std::size_t k ) const {
+		assert( k < size() );
+		index n = _root;
+		while ( k != size_of( at( n )._left ) ) {
+			if ( k < size_of( at( n )._left ) ) {
+				n = at( n )._left;
+			} else {
+				k -= size_of( at( n )._left ) + 1;
+				n = at( n )._right;
+			}
+		}
+		return at( n ).key();
+	}
+
+	//	the number of keys less than k
+	std::size_t rank( const Key &k ) const { return rank_of( k ); }
+	template< typename K > requires transparent< Compare >
+	std::size_t rank( const K &k ) const { return rank_of( k ); }
+
+	template< typename K >
+	std::size_t rank_of( const K &k ) const {
+		std::size_t less = 0;
+		for ( index n = _root; n; ) {
+			if ( !_less( at( n ).key(), k ) ) {
+				n = at( n )._left;
+			} else {
+				less += size_of( at( n )._left ) + 1;
+				n = at( n )._right;
+			}
+		}
+		return less;
 	}
 	
-	void copy( std::vector<int> &v ) const {
-		if ( !root() ) return;
-		root()->copy( v );
+	//	in-order walk with an explicit stack of the pending ancestors
+	void copy( std::vector<Key> &v ) const {
+		v.reserve( v.size() + size() );
+		std::vector<index> pending;
+		for ( index n = _root; n || !pending.empty(); n = at( n )._right ) {
+			for ( ; n; n = at( n )._left ) pending.push_back( n );
+			n = pending.back();
+			pending.pop_back();
+			v.push_back( at( n ).key() );
+		}
 	}
 
 	void print() const {
-		std::queue<node*> layer;
+		std::queue<const node*> layer;
 		if ( root() ) layer.push( root() );
 		while( !layer.empty() ) {
-			std::queue<node*> next_layer;
+			std::queue<const node*> next_layer;
 			while ( !layer.empty() ) {
 				auto i = layer.front();
 				layer.pop();
@@ -268,6 +931,265 @@ struct treap {
 	}
 };
 
+using treap = basic_treap< int >;
+
+// ================ CONCURRENT =====================
+
+/* Immutable nodes shared through ‹std::shared_ptr›. A modification never
+ * changes a node in place – it copies the path from the root down to
+ * the change ( expected O(log n) nodes ) and returns the new root, while
+ * the rest of the tree is shared with the previous version. Whoever
+ * still holds an old root keeps seeing a consistent tree, and its nodes
+ * are freed when the last reference goes away. */
+
+struct shared_node {
+	using ptr = std::shared_ptr< const shared_node >;
+
+	int _key;
+	int _priority;
+	ptr _left, _right;
+	std::size_t _size;
+
+	shared_node( int k, int p, ptr l, ptr r )
+		: _key( k ), _priority( p ), _left( std::move( l ) ), _right( std::move( r ) ),
+		  _size( 1 + size_of( _left ) + size_of( _right ) ) {}
+
+	const shared_node *left() const   { return _left.get(); }
+	const shared_node *right() const  { return _right.get(); }
+	int key() const 	   { return _key; }
+	int priority() const { return _priority; }
+
+	static std::size_t size_of( const ptr &n ) { return n ? n->_size : 0; }
+	static ptr make( int k, int p, ptr l, ptr r ) {
+		return std::make_shared< const shared_node >( k, p, std::move( l ), std::move( r ) );
+	}
+	//	a copy of n with other children
+	static ptr with( const ptr &n, ptr l, ptr r ) {
+		return make( n->_key, n->_priority, std::move( l ), std::move( r ) );
+	}
+
+	static const shared_node *find( const shared_node *n, int k ) {
+		while ( n && n->_key != k ) n = ( k < n->_key ) ? n->_left.get() : n->_right.get();
+		return n;
+	}
+	static bool contains( const shared_node *n, int k ) { return find( n, k ); }
+
+	//	k must not be present in n
+	static void split( const ptr &n, int k, ptr &less, ptr &greater ) {
+		if ( !n ) {
+			less = greater = nullptr;
+		} else if ( n->_key < k ) {
+			split( n->_right, k, less, greater );
+			less = with( n, n->_left, less );
+		} else {
+			split( n->_left, k, less, greater );
+			greater = with( n, greater, n->_right );
+		}
+	}
+	static ptr join( const ptr &l, const ptr &r ) {
+		if ( !l || !r ) return l ? l : r;
+		if ( l->_priority >= r->_priority ) return with( l, l->_left, join( l->_right, r ) );
+		return with( r, join( l, r->_left ), r->_right );
+	}
+
+	//	k must not be present in n
+	static ptr insert( const ptr &n, int k, int p ) {
+		if ( !n || p > n->_priority ) {
+			ptr less, greater;
+			split( n, k, less, greater );
+			return make( k, p, less, greater );
+		}
+		if ( k < n->_key ) return with( n, insert( n->_left, k, p ), n->_right );
+		return with( n, n->_left, insert( n->_right, k, p ) );
+	}
+	//	k must be present in n
+	static ptr erase( const ptr &n, int k ) {
+		if ( n->_key == k ) return join( n->_left, n->_right );
+		if ( k < n->_key ) return with( n, erase( n->_left, k ), n->_right );
+		return with( n, n->_left, erase( n->_right, k ) );
+	}
+};
+
+/* The same shared nodes make a treap whose copies are snapshots: a
+ * copy ( or ‹snapshot› ) only shares the root, in O(1), and the later
+ * modifications of either side copy their paths instead of touching
+ * the shared nodes. The interface is that of ‹treap›. */
+
+struct persistent_treap {
+	shared_node::ptr _root;
+
+	persistent_treap snapshot() const { return *this; }
+
+	const shared_node *root() const { return _root.get(); }
+
+	bool insert( int k, int p = rand() ) {
+		if ( contains( k ) ) return false;
+		_root = shared_node::insert( _root, k, p );
+		return true;
+	}
+	bool erase( int k ) {
+		if ( !contains( k ) ) return false;
+		_root = shared_node::erase( _root, k );
+		return true;
+	}
+	bool contains( int k ) const { return shared_node::contains( root(), k ); }
+	int priority( int k ) const {
+		const shared_node *n = shared_node::find( root(), k );
+		return n ? n->priority() : -1;
+	}
+
+	void clear() { _root = nullptr; }
+	std::size_t size() const { return shared_node::size_of( _root ); }
+
+	void copy( std::vector<int> &v ) const {
+		v.reserve( v.size() + size() );
+		std::vector< const shared_node * > pending;
+		for ( const shared_node *n = root(); n || !pending.empty(); n = n->right() ) {
+			for ( ; n; n = n->left() ) pending.push_back( n );
+			n = pending.back();
+			pending.pop_back();
+			v.push_back( n->key() );
+		}
+	}
+};
+
+/* Epoch-based reclamation for the readers of ‹concurrent_treap›. A
+ * reader announces the global epoch in a slot of its own ( a cache line
+ * per thread, claimed on the first read ) before it loads a root and
+ * clears it when done, so readers write nothing shared. A writer that
+ * replaces a root bumps the epoch and keeps the old version alive until
+ * every announced epoch is past the bump: a reader which could still
+ * see the old root has announced an epoch not greater than that. */
+
+struct alignas( 64 ) epoch_slot {
+	static constexpr std::uint64_t idle = ~std::uint64_t( 0 );
+	std::atomic< std::uint64_t > epoch = idle;
+	std::atomic< bool > taken = false;
+};
+
+struct epoch_domain {
+	using slot = epoch_slot;
+	static constexpr std::uint64_t idle = slot::idle;
+	static constexpr std::size_t max_threads = 128;
+
+	static inline std::atomic< std::uint64_t > global = 0;
+	static inline std::array< slot, max_threads > slots;
+
+	//	the slot of this thread, or null if all are taken
+	static slot *mine() {
+		struct owner {
+			slot *s = nullptr;
+			owner() {
+				for ( auto &c : slots ) {
+					bool free = false;
+					if ( c.taken.compare_exchange_strong( free, true ) ) { s = &c; break; }
+				}
+			}
+			~owner() { if ( s ) s->taken = false; }
+		};
+		thread_local owner o;
+		return o.s;
+	}
+
+	//	the oldest epoch a reader is in, idle if there is none
+	static std::uint64_t oldest_reader() {
+		std::uint64_t oldest = idle;
+		for ( auto &c : slots ) oldest = std::min( oldest, c.epoch.load() );
+		return oldest;
+	}
+
+	struct read_guard {
+		slot *_slot = mine();
+		read_guard() { if ( _slot ) _slot->epoch.store( global.load() ); }
+		~read_guard() { if ( _slot ) _slot->epoch.store( idle, std::memory_order_release ); }
+		read_guard( const read_guard & ) = delete;
+		read_guard &operator=( const read_guard & ) = delete;
+	};
+};
+
+/* A set for many concurrent readers and occasional writers. The keys
+ * are spread over shards by a hash, each shard is a tree of shared
+ * nodes published through an atomic raw pointer to its root. Readers
+ * only load the root inside an epoch ( see above ) and never wait for
+ * a writer nor touch a reference count ( read-copy-update ); writers
+ * build the new version of their shard under its mutex, so writers of
+ * different shards proceed in parallel. A replaced version is retired
+ * and its nodes which are not shared with the new one are freed once
+ * no reader can see it. */
+
+struct concurrent_treap {
+	static constexpr std::size_t shard_count = 16;
+
+	struct shard {
+		std::atomic< const shared_node * > _root = nullptr;
+		mutable std::mutex _writer;
+		// the rest is used under the writer lock only
+		shared_node::ptr _current;			// owns what _root points to
+		std::vector< std::pair< std::uint64_t, shared_node::ptr > > _retired;	// by retirement epoch
+		std::minstd_rand _priorities;
+	};
+	std::array< shard, shard_count > _shards;
+
+	concurrent_treap() {
+		for ( std::size_t i = 0; i < shard_count; ++i ) _shards[i]._priorities.seed( i + 1 );
+	}
+	concurrent_treap( const concurrent_treap & ) = delete;
+	concurrent_treap &operator=( const concurrent_treap & ) = delete;
+
+	static std::size_t shard_index( int k ) {
+		return ( static_cast< std::uint32_t >( k ) * 2654435761u ) >> 28;		// top 4 bits
+	}
+	shard &shard_of( int k ) { return _shards[ shard_index( k ) ]; }
+	const shard &shard_of( int k ) const { return _shards[ shard_index( k ) ]; }
+
+	bool contains( int k ) const {
+		const shard &s = shard_of( k );
+		epoch_domain::read_guard guard;
+		if ( !guard._slot ) {		// more threads than slots, read under the lock
+			std::lock_guard< std::mutex > lock( s._writer );
+			return shared_node::contains( s._current.get(), k );
+		}
+		return shared_node::contains( s._root.load(), k );
+	}
+
+	//	called under the writer lock
+	void publish( shard &s, shared_node::ptr root ) {
+		s._root.store( root.get() );
+		std::uint64_t retired_at = epoch_domain::global.fetch_add( 1 );
+		s._retired.emplace_back( retired_at, std::move( s._current ) );
+		s._current = std::move( root );
+		std::uint64_t oldest = epoch_domain::oldest_reader();
+		std::erase_if( s._retired, [ & ]( const auto &r ) { return r.first < oldest; } );
+	}
+
+	bool insert( int k ) {
+		shard &s = shard_of( k );
+		std::lock_guard< std::mutex > guard( s._writer );
+		if ( shared_node::contains( s._current.get(), k ) ) return false;
+		int p = s._priorities() & 0x7fffffff;
+		publish( s, shared_node::insert( s._current, k, p ) );
+		return true;
+	}
+
+	bool erase( int k ) {
+		shard &s = shard_of( k );
+		std::lock_guard< std::mutex > guard( s._writer );
+		if ( !shared_node::contains( s._current.get(), k ) ) return false;
+		publish( s, shared_node::erase( s._current, k ) );
+		return true;
+	}
+
+	//	exact only when there are no concurrent writers
+	std::size_t size() const {
+		std::size_t total = 0;
+		for ( auto &s : _shards ) {
+			std::lock_guard< std::mutex > lock( s._writer );
+			total += shared_node::size_of( s._current );
+		}
+		return total;
+	}
+};
+
 void print( std::vector<int> v ) {
 	std::cout << "< ";
 	for ( auto i : v ) {
@@ -340,6 +1262,498 @@ void test_copy() {
 	assert( !temp_t.contains(1) ) ;
 }
 
+//	checks the search tree and heap properties and the parent links
+std::size_t check( const treap &t, node::index n, node::index parent ) {
+	if ( !n ) return 0;
+	const node &x = t.at( n );
+	assert( x._self == n && x._parent == parent );
+	for ( node::index c : { x._left, x._right } ) {
+		if ( c ) assert( t.at( c ).priority() <= x.priority() );
+	}
+	if ( x._left ) assert( t.at( x._left ).key() < x.key() );
+	if ( x._right ) assert( t.at( x._right ).key() > x.key() );
+	std::size_t size = 1 + check( t, x._left, n ) + check( t, x._right, n );
+	assert( x._size == size );
+	return size;
+}
+
+void test_order() {
+	std::cout << "TEST ORDER" << std::endl;
+	treap t;
+	std::set<int> ref;
+	std::mt19937 gen( 9 );
+	for ( int i = 0; i < 5000; ++i ) {
+		int k = gen() % 1000;
+		if ( gen() % 4 ) { t.insert( k ); ref.insert( k ); }
+		else { t.erase( k ); ref.erase( k ); }
+		assert( t.size() == ref.size() );
+	}
+	assert( check( t, t._root, 0 ) == ref.size() );
+	std::size_t i = 0;
+	for ( int k : ref ) {
+		assert( t.kth( i ) == k && t.rank( k ) == i );
+		assert( t.rank( k + 1 ) == i + 1 );
+		++i;
+	}
+	assert( t.rank( -1 ) == 0 && t.rank( 1000 ) == ref.size() );
+	t.clear();
+	assert( t.size() == 0 && t.rank( 5 ) == 0 );
+}
+
+void test_pool() {
+	std::cout << "TEST POOL" << std::endl;
+	treap t;
+	std::set<int> ref;
+	std::mt19937 gen( 5 );
+	for ( int i = 0; i < 20000; ++i ) {
+		int k = gen() % 2000;
+		if ( gen() % 3 ) assert( t.insert( k ) == ref.insert( k ).second );
+		else assert( t.erase( k ) == ( ref.erase( k ) == 1 ) );
+	}
+	assert( check( t, t._root, 0 ) == ref.size() && t.size() == ref.size() );
+	std::vector<int> v;
+	t.copy( v );
+	assert( std::equal( v.begin(), v.end(), ref.begin(), ref.end() ) );
+	assert( t._pool.size() <= 2001 );			// erased slots are reused
+
+	treap copy = t, moved = std::move( t );
+	assert( !t.root() && t.size() == 0 && t.insert( 3 ) && t.contains( 3 ) );
+	assert( check( copy, copy._root, 0 ) == ref.size() );
+	assert( check( moved, moved._root, 0 ) == ref.size() );
+
+	std::size_t capacity = moved._pool.capacity();
+	moved.clear();
+	assert( !moved.root() && moved.size() == 0 && moved._pool.capacity() == capacity );
+	assert( moved.insert( 1 ) && moved.contains( 1 ) && !moved.contains( 2 ) );
+}
+
+//	insert, contains and erase of n random keys
+void bench_treap() {
+	for ( std::size_t n : { 1'000'000, 10'000'000, 100'000'000 } ) {
+		std::mt19937 gen( 42 );
+		std::vector<int> keys( n );
+		for ( auto &k : keys ) k = gen();
+		treap t;
+		std::size_t found = 0;
+		auto time = [ & ]( auto op ) {
+			auto start = std::chrono::steady_clock::now();
+			for ( int k : keys ) found += op( k );
+			std::chrono::duration<double> took = std::chrono::steady_clock::now() - start;
+			return took.count();
+		};
+		double ins = time( [ & ]( int k ) { return t.insert( k, gen() ); } );
+		double look = time( [ & ]( int k ) { return t.contains( k ); } );
+		double era = time( [ & ]( int k ) { return t.erase( k ); } );
+		std::cout << n << " keys: insert " << ins << " s, contains " << look 
+				  << " s, erase " << era << " s ( " << found << " )" << std::endl;
+	}
+}
+
+std::vector<int> keys_of( const treap &t ) {
+	std::vector<int> v;
+	t.copy( v );
+	return v;
+}
+
+std::vector<int> random_keys( std::mt19937 &gen, std::size_t n, int range ) {
+	std::set<int> keys;
+	while ( keys.size() < n ) keys.insert( gen() % range );
+	return { keys.begin(), keys.end() };
+}
+
+void test_bulk() {
+	std::cout << "TEST BULK" << std::endl;
+	std::mt19937 gen( 3 );
+	std::size_t grain = treap::parallel_grain;
+	unsigned forks = fork_budget::max_forks;
+	treap::parallel_grain = 64;
+	fork_budget::max_forks = 3;		// fork even on a single core
+
+	std::vector<int> sorted = random_keys( gen, 3000, 100000 );
+	treap t( sorted );
+	assert( check( t, t._root, 0 ) == sorted.size() && keys_of( t ) == sorted );
+	assert( treap( std::vector<int>{} ).size() == 0 );
+
+	int pivot = sorted[ 1234 ];
+	treap high = t.split( pivot );
+	assert( check( t, t._root, 0 ) == 1234 && check( high, high._root, 0 ) == 3000 - 1234 );
+	assert( t.kth( 1233 ) == sorted[ 1233 ] && high.kth( 0 ) == pivot );
+	t.merge( high );
+	assert( check( t, t._root, 0 ) == 3000 && keys_of( t ) == sorted );
+
+	std::size_t count = std::lower_bound( sorted.begin(), sorted.end(), 60000 ) - 
+						std::lower_bound( sorted.begin(), sorted.end(), 20000 );
+	assert( t.erase( 20000, 60000 ) == count && !t.erase( 20000, 60000 ) );
+	assert( t.size() == 3000 - count && t.rank( 60000 ) == t.rank( 20000 ) );
+	assert( check( t, t._root, 0 ) == t.size() && t.insert( 30000 ) );
+
+	for ( auto [ m, n ] : { std::pair{ 10, 5000 }, { 2000, 2000 }, { 5000, 0 }, { 300, 3000 } } ) {
+		std::vector<int> a = random_keys( gen, m, 20000 ), b = random_keys( gen, n, 20000 ), ref;
+		auto same = [ & ]( const treap &r ) {
+			return check( r, r._root, 0 ) == ref.size() && keys_of( r ) == ref;
+		};
+		treap ta( a ), tb( b );
+		ref.clear();
+		std::set_union( a.begin(), a.end(), b.begin(), b.end(), std::back_inserter( ref ) );
+		assert( same( treap( ta ).unite( tb ) ) && same( treap( tb ).unite( ta ) ) );
+		ref.clear();
+		std::set_intersection( a.begin(), a.end(), b.begin(), b.end(), std::back_inserter( ref ) );
+		assert( same( treap( ta ).intersect( tb ) ) && same( treap( tb ).intersect( ta ) ) );
+		ref.clear();
+		std::set_difference( a.begin(), a.end(), b.begin(), b.end(), std::back_inserter( ref ) );
+		treap diff = ta;
+		assert( same( diff.subtract( tb ) ) );
+		assert( diff.insert( -1 ) && diff.erase( -1 ) && same( diff ) );
+	}
+	treap self( sorted );
+	assert( keys_of( self.unite( self ) ) == sorted && self.subtract( self ).size() == 0 );
+	assert( fork_budget::active_forks == 0 );
+	treap::parallel_grain = grain;
+	fork_budget::max_forks = forks;
+}
+
+//	sorted keys with increasing priorities give a tree of depth n
+treap degenerate_treap( int n ) {
+	treap t;
+	for ( int i = 0; i < n; ++i ) t.insert( i, i );
+	return t;
+}
+
+void test_iterative() {
+	std::cout << "TEST ITERATIVE" << std::endl;
+	int n = 1'000'000;
+	treap deep = degenerate_treap( n );
+	assert( deep.size() == std::size_t( n ) && deep.root()->key() == n - 1 );
+	std::vector<int> v;
+	deep.copy( v );
+	assert( v.size() == std::size_t( n ) && std::is_sorted( v.begin(), v.end() ) );
+	deep.erase( n / 2 );
+	deep.insert( n / 2, n / 2 );		// the slot is reused, no free ones left
+	treap copy = deep;
+	assert( copy._pool.size() == std::size_t( n ) + 1 && copy.size() == std::size_t( n ) );
+	assert( copy.root()->key() == n - 1 && copy.root()->left()->key() == n - 2 );
+	assert( copy.kth( 12345 ) == 12345 && copy.erase( 0 ) && !copy.contains( 0 ) );
+
+	treap sparse;
+	for ( int i = 0; i < 1000; ++i ) sparse.insert( i );
+	for ( int i = 0; i < 1000; i += 2 ) sparse.erase( i );
+	treap compact = sparse;
+	assert( compact._pool.size() == 501 && check( compact, compact._root, 0 ) == 500 );
+	assert( keys_of( compact ) == keys_of( sparse ) );
+	compact = deep;
+	assert( compact.size() == std::size_t( n ) && compact.contains( 0 ) );
+}
+
+//	copy of a treap and of its keys
+void bench_copy() {
+	std::mt19937 gen( 42 );
+	std::vector<int> keys( 10'000'000 );
+	std::generate( keys.begin(), keys.end(), gen );
+	treap t;
+	for ( int k : keys ) t.insert( k );
+	auto start = std::chrono::steady_clock::now();
+	treap copy = t;
+	std::chrono::duration<double> deep = std::chrono::steady_clock::now() - start;
+	start = std::chrono::steady_clock::now();
+	std::vector<int> v;
+	copy.copy( v );
+	std::chrono::duration<double> in_order = std::chrono::steady_clock::now() - start;
+	std::cout << t.size() << " keys: deep copy " << deep.count() << " s, copy of keys " 
+			  << in_order.count() << " s" << std::endl;
+
+	for ( int i = 0; i < 1000; ++i ) t.erase( keys[i] );
+	start = std::chrono::steady_clock::now();
+	treap compact = t;
+	deep = std::chrono::steady_clock::now() - start;
+	v.clear();
+	start = std::chrono::steady_clock::now();
+	compact.copy( v );
+	in_order = std::chrono::steady_clock::now() - start;
+	std::cout << "with free slots: compacting copy " << deep.count() << " s, copy of keys " 
+			  << in_order.count() << " s" << std::endl;
+}
+
+void test_concurrent() {
+	std::cout << "TEST CONCURRENT" << std::endl;
+	concurrent_treap t;
+	const int writers = 4, per_writer = 5000;
+	for ( int k = 0; k < per_writer * writers; k += 2 ) assert( t.insert( -1 - k ) );
+	std::atomic< bool > done = false;
+	std::vector< std::thread > threads;
+	for ( int w = 0; w < writers; ++w ) {
+		threads.emplace_back( [ &, w ] {
+			for ( int i = 0; i < per_writer; ++i ) assert( t.insert( w * per_writer + i ) );
+			for ( int i = 0; i < per_writer; i += 2 ) assert( t.erase( w * per_writer + i ) );
+		} );
+	}
+	for ( int r = 0; r < 2; ++r ) {
+		threads.emplace_back( [ & ] {		// the prefilled keys stay visible throughout
+			while ( !done ) {
+				for ( int k = 0; k < per_writer * writers; k += 2 ) assert( t.contains( -1 - k ) );
+			}
+		} );
+	}
+	for ( int w = 0; w < writers; ++w ) threads[w].join();
+	done = true;
+	for ( auto &th : threads ) if ( th.joinable() ) th.join();
+
+	assert( t.size() == std::size_t( writers * per_writer ) );
+	for ( int k = 0; k < per_writer * writers; ++k ) assert( t.contains( k ) == ( k % 2 == 1 ) );
+	assert( !t.insert( 1 ) && t.insert( 0 ) && t.erase( 0 ) && !t.erase( 0 ) );
+	// with no reader left, a write frees all the retired versions of its shard
+	assert( t.shard_of( 0 )._retired.empty() );
+}
+
+//	contains() throughput for different numbers of reader threads,
+//	while one more thread keeps inserting and erasing
+void bench_concurrent() {
+	concurrent_treap t;
+	std::mt19937 gen( 42 );
+	std::vector<int> keys( 1'000'000 );
+	for ( auto &k : keys ) { k = gen(); t.insert( k ); }
+	unsigned max_readers = std::max( 1u, std::thread::hardware_concurrency() );
+	for ( unsigned readers = 1; readers <= max_readers; readers *= 2 ) {
+		std::atomic< bool > done = false;
+		std::atomic< std::size_t > lookups = 0, hits = 0;
+		std::thread writer( [ & ] {
+			for ( int k = 0; !done; ++k ) {
+				if ( t.insert( k ) ) t.erase( k );		// leaves the looked up keys alone
+				std::this_thread::sleep_for( std::chrono::microseconds( 100 ) );
+			}
+		} );
+		std::vector< std::thread > threads;
+		for ( unsigned r = 0; r < readers; ++r ) {
+			threads.emplace_back( [ &, r ] {
+				std::size_t count = 0, found = 0;
+				for ( std::size_t i = r; !done; i += readers, ++count ) found += t.contains( keys[ i % keys.size() ] );
+				lookups += count;
+				hits += found;
+			} );
+		}
+		std::this_thread::sleep_for( std::chrono::seconds( 1 ) );
+		done = true;
+		writer.join();
+		for ( auto &th : threads ) th.join();
+		assert( hits == lookups );
+		std::cout << readers << " readers: " << lookups << " lookups/s" << std::endl;
+	}
+}
+
+void test_persistent() {
+	std::cout << "TEST PERSISTENT" << std::endl;
+	persistent_treap t;
+	std::set<int> ref;
+	std::vector< std::pair< persistent_treap, std::vector<int> > > snapshots;
+	std::mt19937 gen( 17 );
+	for ( int i = 0; i < 5000; ++i ) {
+		int k = gen() % 500;
+		if ( gen() % 3 ) assert( t.insert( k ) == ref.insert( k ).second );
+		else assert( t.erase( k ) == ( ref.erase( k ) == 1 ) );
+		if ( i % 500 == 0 ) snapshots.emplace_back( t.snapshot(), std::vector<int>( ref.begin(), ref.end() ) );
+	}
+	std::vector<int> v;
+	t.copy( v );
+	assert( t.size() == ref.size() && std::equal( v.begin(), v.end(), ref.begin(), ref.end() ) );
+	for ( auto &[ snap, keys ] : snapshots ) {		// unaffected by the later changes
+		v.clear();
+		snap.copy( v );
+		assert( v == keys && snap.size() == keys.size() );
+	}
+
+	persistent_treap a;
+	for ( int k = 0; k < 1000; ++k ) a.insert( k );
+	persistent_treap b = a;
+	assert( b.root() == a.root() );
+	assert( b.insert( 5000, 12345 ) && b.priority( 5000 ) == 12345 && !a.contains( 5000 ) );
+	assert( b.root() != a.root() && b.root()->left() == a.root()->left() );	// only a path is copied
+	int top = a.root()->key();
+	assert( b.erase( top ) && !b.contains( top ) && a.contains( top ) && a.size() == 1000 );
+	b.clear();
+	assert( b.size() == 0 && a.size() == 1000 && a.contains( 999 ) );
+}
+
+void test_generic() {
+	std::cout << "TEST GENERIC" << std::endl;
+	static_assert( sizeof( node ) == 7 * sizeof( std::uint32_t ) );
+
+	basic_treap< std::string, std::less<> > words;
+	for ( const char *w : { "pear", "apple", "fig", "plum", "kiwi", "apple" } ) words.insert( w );
+	std::string_view fig = "fig";
+	assert( words.size() == 5 && words.contains( fig ) && words.contains( "kiwi" ) );
+	assert( !words.contains( std::string_view( "figs" ) ) && words.rank( fig ) == 1 );
+	assert( words.kth( 0 ) == "apple" && words.erase( std::string_view( "pear" ) ) );
+	std::vector< std::string > v;
+	words.copy( v );
+	assert(( v == std::vector< std::string >{ "apple", "fig", "kiwi", "plum" } ));
+	auto high = words.split( "g" );
+	assert( words.size() == 2 && high.size() == 2 && high.kth( 0 ) == "kiwi" );
+
+	basic_treap< int, std::greater< int > > desc( std::vector{ 9, 7, 4, 1 } );
+	std::vector< int > keys;
+	desc.insert( 5 );
+	desc.copy( keys );
+	assert(( keys == std::vector{ 9, 7, 5, 4, 1 } ));
+	assert( desc.erase( 9, 4 ) == 3 && desc.size() == 2 );
+
+	treap a( 123 ), b( 123 ), c( 456 );
+	for ( int k = 0; k < 100; ++k ) { a.insert( k ); b.insert( k ); c.insert( k ); }
+	for ( int k = 0; k < 100; ++k ) assert( a.priority( k ) == b.priority( k ) );
+	int same = 0;
+	for ( int k = 0; k < 100; ++k ) same += a.priority( k ) == c.priority( k );
+	assert( same < 5 && a.priority( 100 ) == -1 );
+
+	std::pmr::monotonic_buffer_resource arena;
+	basic_treap< int, std::less< int >, std::pmr::polymorphic_allocator< int > > 
+		in_arena( 1, {}, &arena );
+	for ( int k = 0; k < 1000; ++k ) in_arena.insert( k );
+	assert( in_arena.size() == 1000 && in_arena._pool.get_allocator().resource() == &arena );
+	auto copied = in_arena;
+	assert( copied.kth( 500 ) == 500 );		// like pmr containers, a copy does not inherit the resource
+	assert( copied._pool.get_allocator().resource() == std::pmr::get_default_resource() );
+
+	// other integer types still convert to the key when the comparison is not transparent
+	treap ints = {};
+	for ( int k = 0; k < 10; ++k ) ints.insert( k );
+	short three = 3;
+	long nine = 9;
+	std::size_t five = 5;
+	assert( ints.contains( three ) && ints.rank( five ) == 5 && *ints.lower_bound( nine ) == 9 );
+	assert( ints.upper_bound( three ) != ints.end() && ints.priority( five ) != -1 );
+	assert( std::distance( ints.range( three, five ).begin(), ints.range( three, five ).end() ) == 2 );
+	assert( ints.erase( nine ) && !ints.contains( nine ) && ints.freeze().contains( three ) );
+	auto empty = []() -> treap { return {}; };
+	assert( empty().size() == 0 );
+}
+
+void test_frozen() {
+	std::cout << "TEST FROZEN" << std::endl;
+	std::mt19937 gen( 21 );
+	for ( std::size_t n : { 0, 1, 2, 3, 7, 8, 100, 4095, 4096, 5000 } ) {
+		std::vector<int> keys = random_keys( gen, n, 20000 );
+		treap t( keys );
+		auto frozen = t.freeze();
+		assert( frozen.size() == n );
+		for ( int k = -1; k <= 20000; ++k ) assert( frozen.contains( k ) == t.contains( k ) );
+	}
+	basic_treap< std::string, std::less<> > words;
+	for ( const char *w : { "pear", "apple", "fig" } ) words.insert( w );
+	auto frozen = words.freeze();
+	assert( frozen.contains( std::string_view( "fig" ) ) && !frozen.contains( "figs" ) );
+}
+
+//	random lookups ( half of them hits ) in the treap and in its frozen copy
+void bench_frozen() {
+	for ( std::size_t n : { 100'000, 1'000'000, 10'000'000 } ) {
+		std::mt19937 gen( 42 );
+		std::vector<int> keys( n ), queries( 10'000'000 );
+		for ( auto &k : keys ) k = gen() & ~1;
+		std::sort( keys.begin(), keys.end() );
+		keys.erase( std::unique( keys.begin(), keys.end() ), keys.end() );
+		for ( auto &q : queries ) q = keys[ gen() % keys.size() ] | ( gen() & 1 );
+		treap t( keys );
+		auto frozen = t.freeze();
+		auto time = [ & ]( const auto &set ) {
+			std::size_t found = 0;
+			auto start = std::chrono::steady_clock::now();
+			for ( int q : queries ) found += set.contains( q );
+			std::chrono::duration<double> took = std::chrono::steady_clock::now() - start;
+			return std::pair{ took.count(), found };
+		};
+		auto [ tree, tree_found ] = time( t );
+		auto [ flat, flat_found ] = time( frozen );
+		assert( tree_found == flat_found );
+		std::cout << keys.size() << " keys, " << queries.size() << " lookups: treap " << tree 
+				  << " s, frozen " << flat << " s" << std::endl;
+	}
+}
+
+void test_iterators() {
+	std::cout << "TEST ITERATORS" << std::endl;
+	static_assert( std::bidirectional_iterator< treap::const_iterator > );
+	treap t;
+	std::set<int> ref;
+	std::mt19937 gen( 33 );
+	for ( int i = 0; i < 3000; ++i ) {
+		int k = gen() % 5000;
+		if ( gen() % 4 ) { t.insert( k ); ref.insert( k ); }
+		else { t.erase( k ); ref.erase( k ); }
+	}
+	assert( std::equal( t.begin(), t.end(), ref.begin(), ref.end() ) );
+	assert( std::equal( std::make_reverse_iterator( t.end() ), std::make_reverse_iterator( t.begin() ), 
+						ref.rbegin(), ref.rend() ) );
+	for ( int k = -1; k <= 5001; k += 7 ) {
+		auto lb = t.lower_bound( k ), ub = t.upper_bound( k );
+		assert( ( lb == t.end() ) == ( ref.lower_bound( k ) == ref.end() ) );
+		assert( lb == t.end() || *lb == *ref.lower_bound( k ) );
+		assert( ub == t.end() || *ub == *ref.upper_bound( k ) );
+		for ( int hi : { k - 1, k, k + 1, k + 100 } ) {
+			auto view = t.range( k, hi );
+			std::size_t expected = ( hi > k ) ? std::distance( ref.lower_bound( k ), ref.lower_bound( hi ) ) : 0;
+			assert( std::size_t( std::distance( view.begin(), view.end() ) ) == expected );
+			for ( int key : view ) assert( k <= key && key < hi && ref.count( key ) );
+		}
+	}
+	treap empty;
+	assert( empty.begin() == empty.end() && empty.lower_bound( 3 ) == empty.end() );
+	auto last = t.end();
+	assert( *--last == *ref.rbegin() && ++last == t.end() );
+}
+
+void test_batch() {
+	std::cout << "TEST BATCH" << std::endl;
+	treap t;
+	std::set<int> ref;
+	std::mt19937 gen( 41 );
+	for ( int round = 0; round < 50; ++round ) {
+		std::vector<int> batch( gen() % 300 );
+		int start = gen() % 10000;
+		for ( std::size_t i = 0; i < batch.size(); ++i ) {		// runs, duplicates and noise
+			batch[i] = ( round % 3 == 0 ) ? int( gen() % 10000 ) : start + int( i ) - int( gen() % 3 );
+		}
+		std::size_t expected = 0;
+		std::vector< std::pair< int, decltype( t.priority( 0 ) ) > > present;
+		for ( int k : batch ) if ( ref.count( k ) ) present.emplace_back( k, t.priority( k ) );
+		for ( int k : batch ) expected += ref.insert( k ).second;
+		assert( t.insert_batch( batch ) == expected );
+		for ( auto [ k, p ] : present ) assert( t.priority( k ) == p );		// as if inserted one by one
+		assert( check( t, t._root, 0 ) == ref.size() );
+		if ( round % 5 == 4 ) for ( int k = 0; k < 10000; k += 3 ) { t.erase( k ); ref.erase( k ); }
+	}
+	assert( std::equal( t.begin(), t.end(), ref.begin(), ref.end() ) );
+	assert( t.insert_batch( std::vector<int>{} ) == 0 && t.insert( 20000 ) );
+}
+
+//	n keys inserted one by one and in batches, for sorted, nearly sorted
+//	and random streams
+void bench_batch() {
+	const std::size_t n = 2'000'000, batch = 1000;
+	std::mt19937 gen( 42 );
+	std::vector<int> sorted( n ), nearly, shuffled;
+	for ( std::size_t i = 0; i < n; ++i ) sorted[i] = int( 2 * i );
+	nearly = sorted;
+	for ( std::size_t i = 0; i < n / 100; ++i ) std::swap( nearly[ gen() % n ], nearly[ gen() % n ] );
+	shuffled = sorted;
+	std::shuffle( shuffled.begin(), shuffled.end(), gen );
+	for ( auto [ name, keys ] : { std::pair{ "sorted", &sorted }, { "nearly sorted", &nearly }, 
+								   { "random", &shuffled } } ) {
+		auto time = [ & ]( auto fn ) {
+			treap t;
+			auto start = std::chrono::steady_clock::now();
+			fn( t );
+			std::chrono::duration<double> took = std::chrono::steady_clock::now() - start;
+			assert( t.size() == n );
+			return took.count();
+		};
+		double single = time( [ & ]( treap &t ) { for ( int k : *keys ) t.insert( k ); } );
+		double batched = time( [ & ]( treap &t ) { 
+			for ( std::size_t i = 0; i < n; i += batch ) {
+				t.insert_batch( std::span< const int >( keys->data() + i, batch ) );
+			}
+		} );
+		std::cout << name << ": insert " << single << " s, insert_batch " << batched << " s" << std::endl;
+	}
+}
+
 int main()
 {
     treap t;
@@ -366,6 +1780,21 @@ int main()
     //test_insert();
     test_erase();
     test_copy();
+    test_pool();
+    test_order();
+    test_bulk();
+    test_iterative();
+    test_concurrent();
+    test_persistent();
+    test_generic();
+    test_frozen();
+    test_iterators();
+    test_batch();
+    //bench_treap();
+    //bench_copy();
+    //bench_concurrent();
+    //bench_frozen();
+    //bench_batch();
 
     return 0;
 }
@@ -6,6 +6,17 @@
 #include <map>
 #include <iostream>
 #include <memory>
+#include <array>
+#include <limits>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <random>
+#include <chrono>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 /* V této úloze budete programovat jednoduchou hru, ve které se ve
  * volném třírozměrném prostoru pohybují robotické entity tří barev:
@@ -113,7 +124,8 @@ position operator*( position p, double scale ) {
 double euclid_dist( position a, position b ) {
 	auto [m,n,o] = a;
 	auto [x,y,z] = b;
-	return std::sqrt( std::pow(x-m, 2) + std::pow(y-n, 2) + std::pow(z-o, 2) );
+	// same as std::pow( d, 2 ), which is exact for squares, without the call
+	return std::sqrt( (x-m)*(x-m) + (y-n)*(y-n) + (z-o)*(z-o) );
 }
 
 position unit_direction( position start, position target ) {
@@ -143,112 +155,434 @@ Robot_type get_enemy_type( Robot_type rt ) {
 	}
 }
 
-struct robot {
+/* The robots are kept as a structure of arrays, one ‹robot_group› per
+ * colour: coordinates, owners and targets live in separate vectors, so
+ * the movement rule of a colour is a plain loop over doubles which the
+ * compiler can vectorize, instead of a virtual call per robot.
+ *
+ * Every robot gets an ‹id› in the order of creation; the ids also break
+ * the ties between equally near enemies. Targets refer to robots by id,
+ * the game maps the ids of the live robots to their slot in the group. */
+
+using robot_id = std::uint32_t;
+const robot_id no_robot = -1;
+const double base_speed = 15;
+
+struct robot_group {
 	Robot_type type;
-	int player_id;
-	position pos, next_pos;
-	robot *target = nullptr;
-	double base_speed = 15;
+	std::vector< double > x, y, z;
+	std::vector< double > next_x, next_y, next_z;
+	std::vector< double > dir_x, dir_y, dir_z;	// the last direction, used by blue robots
+	std::vector< int > player;
+	std::vector< robot_id > id, target;
 
-	robot( int player, position start ) 
-		: player_id( player ), pos( start ), next_pos( start ) {}
-	
-	virtual void get_next_pos() = 0;
+	//	the target cache: where the robot was, how far the runner-up was
+	//	and how far the enemies could have moved when the target was searched for
+	std::vector< double > seen_x, seen_y, seen_z, runner_up, enemy_travel;
 
-	void move() { 
-		pos = next_pos; 
-	}
+	explicit robot_group( Robot_type t ) : type( t ) {}
+
+	std::size_t size() const { return id.size(); }
+	position pos( std::size_t i ) const { return { x[i], y[i], z[i] }; }
 
-	bool can_attack( const robot *r ) const {
-		return r->type == get_enemy_type( type ) && player_id != r->player_id;
+	void add( robot_id rid, int player_id, position start ) {
+		auto [ sx, sy, sz ] = start;
+		auto [ dx, dy, dz ] = unit_direction( start, { 0, 0, 0 } );
+		x.push_back( sx ); y.push_back( sy ); z.push_back( sz );
+		dir_x.push_back( dx ); dir_y.push_back( dy ); dir_z.push_back( dz );
+		player.push_back( player_id );
+		id.push_back( rid );
+		target.push_back( no_robot );
+		seen_x.push_back( sx ); seen_y.push_back( sy ); seen_z.push_back( sz );
+		runner_up.push_back( 0 );
+		enemy_travel.push_back( 0 );
 	}
 
-	virtual void find_target( std::set<std::unique_ptr<robot>> &robots ) {
-		target = nullptr;
-		for ( auto &r : robots ) {
-			if ( can_attack( r.get() ) && ( !target || euclid_dist( pos, r->pos ) < euclid_dist( pos, target->pos ) ) ) {
-				target = r.get();
-			}
+	//	drops the robots whose ids are marked in dead, the rest keep their order
+	void remove( const std::vector< char > &dead ) {
+		std::size_t kept = 0;
+		for ( std::size_t i = 0; i < size(); ++i ) {
+			if ( dead[ id[i] ] ) continue;
+			x[kept] = x[i]; y[kept] = y[i]; z[kept] = z[i];
+			dir_x[kept] = dir_x[i]; dir_y[kept] = dir_y[i]; dir_z[kept] = dir_z[i];
+			player[kept] = player[i];
+			id[kept] = id[i];
+			target[kept] = target[i];
+			seen_x[kept] = seen_x[i]; seen_y[kept] = seen_y[i]; seen_z[kept] = seen_z[i];
+			runner_up[kept] = runner_up[i];
+			enemy_travel[kept] = enemy_travel[i];
+			++kept;
 		}
+		for ( auto *v : { &x, &y, &z, &dir_x, &dir_y, &dir_z, &seen_x, &seen_y, &seen_z, &runner_up, &enemy_travel } )
+			v->resize( kept );
+		player.resize( kept );
+		id.resize( kept );
+		target.resize( kept );
+	}
+};
+
+//	the positions of the targets, for the robots without one their own position
+struct target_positions {
+	std::vector< double > x, y, z, dist;
+	std::vector< std::int64_t > has;	// all ones or zero, a lane mask for the kernels
+
+	void resize( std::size_t n ) {
+		x.resize( n ); y.resize( n ); z.resize( n ); dist.resize( n ); has.resize( n );
 	}
 
-	virtual ~robot() = default;
+	//	fills in the robots [from, to) of the group, the vectors must be sized already
+	void gather( const robot_group &g, const robot_group &enemies, const std::vector< std::size_t > &slot,
+				 std::size_t from, std::size_t to ) {
+		for ( std::size_t i = from; i < to; ++i ) {
+			bool aimed = g.target[i] != no_robot;
+			std::size_t s = aimed ? slot[ g.target[i] ] : 0;
+			has[i] = aimed ? -1 : 0;
+			x[i] = aimed ? enemies.x[s] : g.x[i];
+			y[i] = aimed ? enemies.y[s] : g.y[i];
+			z[i] = aimed ? enemies.z[s] : g.z[i];
+			dist[i] = euclid_dist( g.pos( i ), { x[i], y[i], z[i] } );
+		}
+	}
 };
 
-void print( const robot *r ) {
-	std::cout << "Robot: { " << r->player_id << ", ";
-	print( r->type );
-	std::cout << ", ";
-	print( r->pos );
-	if ( r->target ) {
-		std::cout << ", target: ";
-		print( r->target->pos );
-		std::cout << " - distance: " << euclid_dist( r->pos, r->target->pos );
+/* The movement rules work on ‹lanes› robots at a time, using the
+ * vector extension of GCC and Clang. Left to itself, the compiler
+ * does not vectorize the scalar loop: the selects between the rules
+ * would need floating-point operations and loads done conditionally,
+ * and ‹std::sqrt› may set ‹errno› – the distances are therefore taken
+ * in the (scalar) gather above.
+ *
+ * Each lane computes exactly what ‹unit_direction› and the scaling in
+ * the original robot classes did, in the same order, so the positions
+ * are bit-for-bit those of the object version. A robot without a
+ * target, or standing on it, divides by infinity to get the zero
+ * direction. */
+
+constexpr std::size_t lanes = 2;	// SSE2, which every x86-64 has
+using vec = double __attribute__(( vector_size( lanes * sizeof( double ) ) ));
+using vec_mask = std::int64_t __attribute__(( vector_size( lanes * sizeof( double ) ) ));
+
+template< typename V, typename T >
+V load( const T *from, std::size_t count ) {
+	V v{};
+	std::memcpy( &v, from, count * sizeof( T ) );
+	return v;
+}
+
+template< typename V, typename T >
+void store( T *to, V v, std::size_t count ) {
+	std::memcpy( to, &v, count * sizeof( T ) );
+}
+
+template< Robot_type type >
+void move_kernel( robot_group &g, const target_positions &t, std::size_t from, std::size_t to ) {
+	const vec inf = vec{} + std::numeric_limits< double >::infinity();
+	const double step = TICK_SIZE, eps = EPSILON;
+
+	for ( std::size_t i = from; i < to; i += lanes ) {
+		std::size_t k = std::min( lanes, to - i );
+		vec x = load< vec >( &g.x[i], k ), y = load< vec >( &g.y[i], k ), z = load< vec >( &g.z[i], k );
+		vec tx = load< vec >( &t.x[i], k ), ty = load< vec >( &t.y[i], k ), tz = load< vec >( &t.z[i], k );
+		vec dist = load< vec >( &t.dist[i], k );
+		vec_mask aimed = load< vec_mask >( &t.has[i], k );
+
+		vec_mask near = ( dist < eps ) & ( dist > -eps );
+		vec div = near ? inf : dist;
+		vec vx = ( tx - x ) / div, vy = ( ty - y ) / div, vz = ( tz - z ) / div;
+		vec nx, ny, nz;
+
+		if constexpr ( type == Robot_type::RED ) {
+			nx = aimed ? x + vx*base_speed*step : x;
+			ny = aimed ? y + vy*base_speed*step : y;
+			nz = aimed ? z + vz*base_speed*step : z;
+		}
+		if constexpr ( type == Robot_type::GREEN ) {
+			vec_mask jump = aimed & ( dist > 10 );
+			nx = jump ? tx + vx*8 : aimed ? x + vx*base_speed*step : x;
+			ny = jump ? ty + vy*8 : aimed ? y + vy*base_speed*step : y;
+			nz = jump ? tz + vz*8 : aimed ? z + vz*base_speed*step : z;
+		}
+		if constexpr ( type == Robot_type::BLUE ) {
+			vec ux = aimed ? vx : load< vec >( &g.dir_x[i], k );
+			vec uy = aimed ? vy : load< vec >( &g.dir_y[i], k );
+			vec uz = aimed ? vz : load< vec >( &g.dir_z[i], k );
+			vec speed = aimed ? vec{} + base_speed : vec{} + base_speed/2.0;
+			store( &g.dir_x[i], ux, k ); store( &g.dir_y[i], uy, k ); store( &g.dir_z[i], uz, k );
+			nx = x + ux*speed*step;
+			ny = y + uy*speed*step;
+			nz = z + uz*speed*step;
+		}
+		store( &g.next_x[i], nx, k ); store( &g.next_y[i], ny, k ); store( &g.next_z[i], nz, k );
 	}
-	std::cout << " }" << std::endl;
 }
 
-struct robot_red : robot {
-	robot_red( int player, position start ) : robot( player, start ) {
-		type = Robot_type::RED;
+/* Uniform grid over the positions of the robots, rebuilt at the start
+ * of every tick – so that the nearest enemy and the enemies within
+ * ‹DEATH_DIST› are found by looking into a few neighbouring cells
+ * instead of at all the robots.
+ *
+ * The grid spans the bounding box of the robots with about one cell
+ * per robot, and every robot type has its own copy of it: the robots
+ * are counting-sorted by cell into one array, together with their
+ * position and owner, so a query reads a single array.
+ *
+ * The cells are at least ‹DEATH_DIST› wide, so the robots within that
+ * distance are always in the 27 cells around. The nearest enemy is
+ * searched for in growing cubic shells of cells around the robot,
+ * until the two best distances found are smaller than the distance to
+ * any cell not yet searched; when a shell would have more cells than
+ * there are robots of the type, the robots are scanned directly.
+ * Ties are broken by the id of the robot, which is also the order
+ * in which a full scan over the group would find them. */
+
+struct spatial_grid {
+	struct cell_key { long x, y, z; };
+	struct entry {
+		position pos;
+		int player_id;
+		robot_id id;
+	};
+	struct layer {
+		std::vector< std::size_t > start;	// entries of cell i are [start[i], start[i + 1])
+		std::vector< entry > entries;
+	};
+
+	position low;
+	double side = 1;
+	cell_key dims{ 0, 0, 0 };
+	std::array< layer, 3 > layers;
+	std::vector< std::size_t > cell_ids;	// scratch, the cell of each robot
+
+	long axis( double v, double from, long count ) const {
+		return std::clamp( long( std::floor( ( v - from ) / side ) ), 0L, count - 1 );
 	}
+	cell_key cell_of( position p ) const {
+		auto [ x, y, z ] = p;
+		auto [ lx, ly, lz ] = low;
+		return { axis( x, lx, dims.x ), axis( y, ly, dims.y ), axis( z, lz, dims.z ) };
+	}
+	std::size_t index( cell_key c ) const {
+		return ( std::size_t( c.z ) * dims.y + c.y ) * dims.x + c.x;
+	}
+
+	void rebuild( const std::array< robot_group, 3 > &groups ) {
+		for ( auto &l : layers ) l.entries.clear();
+		dims = { 0, 0, 0 };
+		std::size_t robots = 0;
+		for ( auto &g : groups ) robots += g.size();
+		if ( robots == 0 ) return;
+
+		double inf = std::numeric_limits< double >::infinity();
+		double lx = inf, ly = inf, lz = inf, hx = -inf, hy = -inf, hz = -inf;
+		for ( auto &g : groups ) {
+			for ( std::size_t i = 0; i < g.size(); ++i ) {
+				lx = std::min( lx, g.x[i] ); ly = std::min( ly, g.y[i] ); lz = std::min( lz, g.z[i] );
+				hx = std::max( hx, g.x[i] ); hy = std::max( hy, g.y[i] ); hz = std::max( hz, g.z[i] );
+			}
+		}
+		low = { lx, ly, lz };
+		double dx = hx - lx, dy = hy - ly, dz = hz - lz;
+		double min_side = DEATH_DIST * ( 1 + EPSILON );
+		double volume = std::max( dx, min_side ) * std::max( dy, min_side ) * std::max( dz, min_side );
+		side = std::max( min_side, std::cbrt( volume / robots ) );
+		auto count = [ & ]( double d ) { return long( d / side ) + 1; };
+		//	a flat cloud in a huge box would get too many cells
+		while ( double( count( dx ) ) * count( dy ) * count( dz ) > 8.0 * robots + 27 ) side *= 2;
+		dims = { count( dx ), count( dy ), count( dz ) };
 
-	void find_target( std::set<std::unique_ptr<robot>> &robots ) override {
-		if ( target ) return;
-		for ( auto &r : robots ) {
-			if ( can_attack( r.get() ) && ( !target || euclid_dist( pos, r->pos ) < euclid_dist( pos, target->pos ) ) ) {
-				target = r.get();
+		std::size_t cells = std::size_t( dims.x ) * dims.y * dims.z;
+		for ( auto &l : layers ) l.start.assign( cells + 1, 0 );
+		for ( auto &g : groups ) {
+			layer &l = layers[ g.type ];
+			l.start.assign( cells + 1, 0 );
+			cell_ids.clear();
+			for ( std::size_t i = 0; i < g.size(); ++i ) {
+				cell_ids.push_back( index( cell_of( g.pos( i ) ) ) );
+				++l.start[ cell_ids.back() + 1 ];
+			}
+			for ( std::size_t c = 0; c < cells; ++c ) l.start[ c + 1 ] += l.start[ c ];
+			l.entries.resize( g.size() );
+			for ( std::size_t i = 0; i < g.size(); ++i ) {
+				l.entries[ l.start[ cell_ids[ i ] ]++ ] = { g.pos( i ), g.player[i], g.id[i] };
 			}
+			//	the placement moved every start to the end of its cell
+			std::copy_backward( l.start.begin(), l.start.end() - 1, l.start.end() );
+			l.start[ 0 ] = 0;
 		}
 	}
-	
-	void get_next_pos() override {
-		if ( !target ) return;
-		next_pos = pos + unit_direction( pos, target->pos )*base_speed*TICK_SIZE;
+
+	template< typename fn_t >
+	void for_cell( const layer &l, long x, long y, long z, fn_t &fn ) const {
+		if ( x < 0 || y < 0 || z < 0 || x >= dims.x || y >= dims.y || z >= dims.z ) return;
+		std::size_t i = index( { x, y, z } );
+		for ( std::size_t e = l.start[ i ]; e < l.start[ i + 1 ]; ++e ) fn( l.entries[ e ] );
 	}
-};
-struct robot_green : robot {
-	robot_green( int player, position start ) : robot( player, start )  {
-		type = Robot_type::GREEN;
+
+	//	calls fn for the entries of the layer in the cells at Chebyshev distance r from c
+	template< typename fn_t >
+	void for_shell( const layer &l, cell_key c, long r, fn_t &fn ) const {
+		for ( long dx = -r; dx <= r; ++dx ) {
+			for ( long dy = -r; dy <= r; ++dy ) {
+				bool face = std::abs( dx ) == r || std::abs( dy ) == r;
+				for ( long dz = -r; dz <= r; dz += ( face || r == 0 ) ? 1 : 2 * r ) {
+					for_cell( l, c.x + dx, c.y + dy, c.z + dz, fn );
+				}
+			}
+		}
 	}
-	
-	void get_next_pos() override {
-		if ( !target ) return;
-		if ( euclid_dist( pos, target->pos ) > 10 ) {
-			next_pos = target->pos + unit_direction( pos, target->pos )*8;
-		} else {
-			next_pos = pos + unit_direction( pos, target->pos )*base_speed*TICK_SIZE;
+
+	//	the nearest robot of the type owned by someone else than player
+	robot_id nearest( Robot_type type, position from, int player ) const {
+		return search( type, from, player ).first;
+	}
+
+	/* Also gives the distance to the runner-up (infinity if there is
+	 * none), so the search goes on until that one is surely found too.
+	 * Any other robot of the type is at least that far. */
+
+	std::pair< robot_id, double > search( Robot_type type, position from, int player ) const {
+		double inf = std::numeric_limits< double >::infinity();
+		if ( dims.x == 0 ) return { no_robot, inf };
+		const layer &l = layers[ type ];
+		robot_id best = no_robot;
+		double best_dist = inf, second_dist = inf;
+		auto consider = [ & ]( const entry &e ) {
+			if ( e.player_id == player ) return;
+			double d = euclid_dist( from, e.pos );
+			if ( best == no_robot || d < best_dist || ( d == best_dist && e.id < best ) ) {
+				second_dist = best_dist;
+				best = e.id;
+				best_dist = d;
+			} else {
+				second_dist = std::min( second_dist, d );
+			}
+		};
+		cell_key c = cell_of( from );
+		long reach = std::max( { c.x, dims.x - 1 - c.x, c.y, dims.y - 1 - c.y, c.z, dims.z - 1 - c.z } );
+		for ( long r = 0; r <= reach; ++r ) {
+			long shell = ( r == 0 ) ? 1 : ( 2*r + 1 ) * ( 2*r + 1 ) * ( 2*r + 1 ) - ( 2*r - 1 ) * ( 2*r - 1 ) * ( 2*r - 1 );
+			if ( shell > long( l.entries.size() ) ) {		// start over, the inner shells included
+				best = no_robot;
+				best_dist = second_dist = inf;
+				for ( const entry &e : l.entries ) consider( e );
+				break;
+			}
+			for_shell( l, c, r, consider );
+			if ( second_dist < r * side * ( 1 - EPSILON ) ) break;
 		}
+		return { best, second_dist };
+	}
+
+	//	calls fn with the id of every robot of the type within DEATH_DIST not owned by player
+	template< typename fn_t >
+	void for_victims( Robot_type type, position from, int player, fn_t fn ) const {
+		if ( dims.x == 0 ) return;
+		const layer &l = layers[ type ];
+		auto hit = [ & ]( const entry &e ) {
+			if ( e.player_id != player && euclid_dist( from, e.pos ) <= DEATH_DIST ) fn( e.id );
+		};
+		cell_key c = cell_of( from );
+		for_shell( l, c, 0, hit );
+		for_shell( l, c, 1, hit );
 	}
 };
-struct robot_blue : robot {
-	position last_direction = unit_direction( pos, {0,0,0} );
 
-	robot_blue( int player, position start ) : robot( player, start ) {
-		type = Robot_type::BLUE;
+/* Threads started once which sleep between the jobs. ‹run› hands the
+ * job to every worker, calls job( 0 ) on the calling thread meanwhile
+ * and returns when all the workers are done; worker w calls job( w + 1 ). */
+
+struct worker_pool {
+	std::vector< std::thread > workers;
+	std::mutex lock;
+	std::condition_variable wake, done;
+	std::function< void( std::size_t ) > job;
+	std::uint64_t generation = 0;		// of the current job
+	std::size_t busy = 0;				// workers not yet done with it
+	bool stop = false;
+
+	explicit worker_pool( std::size_t count ) {
+		for ( std::size_t w = 0; w < count; ++w ) workers.emplace_back( [ this, w ] { work( w ); } );
 	}
-	
-	void get_next_pos() override {
-		if ( !target ) {
-			next_pos = pos + last_direction*(base_speed/2.0)*TICK_SIZE;
-		} else {
-			last_direction = unit_direction( pos, target->pos );
-			next_pos = pos + last_direction*base_speed*TICK_SIZE;
+
+	worker_pool( const worker_pool & ) = delete;
+	worker_pool &operator=( const worker_pool & ) = delete;
+
+	~worker_pool() {
+		{
+			std::lock_guard< std::mutex > guard( lock );
+			stop = true;
 		}
-	}	
+		wake.notify_all();
+		for ( auto &t : workers ) t.join();
+	}
+
+	std::size_t size() const { return workers.size(); }
+
+	void work( std::size_t w ) {
+		std::uint64_t seen = 0;
+		std::unique_lock< std::mutex > guard( lock );
+		while ( true ) {
+			wake.wait( guard, [ & ] { return stop || generation != seen; } );
+			if ( stop ) return;
+			seen = generation;
+			guard.unlock();
+			job( w + 1 );
+			guard.lock();
+			if ( --busy == 0 ) done.notify_one();
+		}
+	}
+
+	template< typename job_t >
+	void run( job_t &&fn ) {
+		{
+			std::lock_guard< std::mutex > guard( lock );
+			job = std::ref( fn );
+			busy = workers.size();
+			++generation;
+		}
+		wake.notify_all();
+		fn( 0 );
+		std::unique_lock< std::mutex > guard( lock );
+		done.wait( guard, [ & ] { return busy == 0; } );
+	}
 };
 
 struct game {
 	std::map<int, std::tuple<int, int, int>> players;
-	std::set<std::unique_ptr<robot>> robots;
+	std::array< robot_group, 3 > groups{ robot_group( Robot_type::RED ), robot_group( Robot_type::GREEN ),
+										 robot_group( Robot_type::BLUE ) };
+	std::vector< std::size_t > slot;	// the slot of a live robot in its group, by id
+	std::vector< char > dead;			// scratch, by id
+	spatial_grid grid;
+	std::array< target_positions, 3 > targets;
 
-	bool game_end() {
-		for ( auto &r : robots ) {
-			for ( auto &o : robots ) {
-				if ( r->can_attack( o.get() ) ) return false;
-			}
-		}
-		return true;
+	robot_group &group( Robot_type t ) { return groups[ t ]; }
+
+	/* For every colour, the number of players who own a robot of it and
+	 * the sum of their ids – when there is only one such player, the sum
+	 * is their id. Kept up to date by ‹count_robot›, so that ‹game_end›
+	 * does not have to look at the robots at all. */
+
+	std::array< int, 3 > owners{};
+	std::array< long long, 3 > owner_ids{};
+
+	void count_robot( int player_id, Robot_type type, int delta ) {
+		int &count = get_robot_count( player_id, type );
+		int sign = ( count == 0 ) - ( count + delta == 0 );
+		count += delta;
+		owners[ type ] += sign;
+		owner_ids[ type ] += sign * player_id;
+	}
+
+	//	is there a robot of the type and an enemy robot owned by someone else
+	bool can_fight( Robot_type type ) const {
+		Robot_type enemy = get_enemy_type( type );
+		if ( !owners[ type ] || !owners[ enemy ] ) return false;
+		return owners[ type ] > 1 || owners[ enemy ] > 1 || owner_ids[ type ] != owner_ids[ enemy ];
+	}
+
+	bool game_end() const {
+		return !can_fight( Robot_type::RED ) && !can_fight( Robot_type::GREEN ) && !can_fight( Robot_type::BLUE );
 	}
 
 	std::vector<int> get_sorted_players() {
@@ -273,34 +607,140 @@ struct game {
 		return std::get<2>( players[player_id] );
 	}
 
+	/* The tick is computed by up to ‹threads› threads, each given a
+	 * contiguous piece of a group of at least ‹parallel_grain› robots.
+	 * The pieces only read the shared state (the grid, the positions)
+	 * and each writes its own robots, or collects the victims in its
+	 * own list which are merged afterwards, so the result does not
+	 * depend on the number of threads. */
+
+	unsigned threads = std::max( 1u, std::thread::hardware_concurrency() );
+	std::size_t parallel_grain = 2048;
+	std::vector< std::vector< robot_id > > victims;	// scratch, by piece
+	mutable std::unique_ptr< worker_pool > pool;	// threads - 1 workers, started by the first parallel tick
+
+	//	the number of pieces [0, n) is cut into and their size, a multiple of lanes
+	std::pair< std::size_t, std::size_t > pieces( std::size_t n ) const {
+		std::size_t count = std::clamp< std::size_t >( n / std::max< std::size_t >( parallel_grain, 1 ), 1, threads );
+		std::size_t size = ( ( n + count - 1 ) / count + lanes - 1 ) / lanes * lanes;
+		return { count, std::max< std::size_t >( size, lanes ) };
+	}
+
+	//	calls fn( piece, from, to ) for the pieces of [0, n), the first one on this thread
+	template< typename fn_t >
+	void parallel_for( std::size_t n, fn_t fn ) const {
+		auto [ count, size ] = pieces( n );
+		if ( count == 1 ) return fn( 0, 0, std::min( n, size ) );
+		if ( !pool || pool->size() != threads - 1 ) pool = std::make_unique< worker_pool >( threads - 1 );
+		pool->run( [ & ]( std::size_t k ) {
+			if ( k < count && k * size < n ) fn( k, k * size, std::min( n, ( k + 1 ) * size ) );
+		} );
+	}
+
+	/* Green and blue robots search for the nearest enemy every tick, but
+	 * between two ticks the robots move only a little. When the target
+	 * was found, the robot remembers its position and the distance to
+	 * the runner-up; since then the robot has moved by its distance from
+	 * the remembered spot and every enemy by at most the sum of the
+	 * longest steps of its colour in each tick (‹travel›). While the
+	 * target is nearer than the runner-up can have come, it is still the
+	 * nearest and the search is skipped. The cache is dropped when the
+	 * target dies (it becomes ‹no_robot›) and when robots are added. */
+
+	bool target_cache = true;
+	bool added = false;							// robots were added since the last tick
+	std::array< double, 3 > travel{};			// by colour, see above
+
+	bool target_holds( const robot_group &g, std::size_t i ) const {
+		if ( !target_cache || added || g.target[i] == no_robot ) return false;
+		Robot_type enemy = get_enemy_type( g.type );
+		position target = groups[ enemy ].pos( slot[ g.target[i] ] );
+		double moved = euclid_dist( g.pos( i ), { g.seen_x[i], g.seen_y[i], g.seen_z[i] } )
+					 + ( travel[ enemy ] - g.enemy_travel[i] );
+		// the margin covers the rounding of the distances
+		return euclid_dist( g.pos( i ), target ) < g.runner_up[i] - moved - EPSILON;
+	}
+
+	void find_targets() {
+		for ( auto &g : groups ) {
+			Robot_type enemy = get_enemy_type( g.type );
+			parallel_for( g.size(), [ & ]( std::size_t, std::size_t from, std::size_t to ) {
+				for ( std::size_t i = from; i < to; ++i ) {
+					// red robots stay locked on their target
+					if ( g.type == Robot_type::RED && g.target[i] != no_robot ) continue;
+					if ( target_holds( g, i ) ) continue;
+					std::tie( g.target[i], g.runner_up[i] ) = grid.search( enemy, g.pos( i ), g.player[i] );
+					g.seen_x[i] = g.x[i]; g.seen_y[i] = g.y[i]; g.seen_z[i] = g.z[i];
+					g.enemy_travel[i] = travel[ enemy ];
+				}
+			} );
+		}
+		added = false;
+	}
+
+	void move_robots() {
+		for ( auto &g : groups ) {
+			target_positions &t = targets[ g.type ];
+			const robot_group &enemies = groups[ get_enemy_type( g.type ) ];
+			t.resize( g.size() );
+			g.next_x.resize( g.size() ); g.next_y.resize( g.size() ); g.next_z.resize( g.size() );
+			parallel_for( g.size(), [ & ]( std::size_t, std::size_t from, std::size_t to ) {
+				t.gather( g, enemies, slot, from, to );
+				switch ( g.type ) {
+					case Robot_type::RED:	move_kernel< Robot_type::RED >( g, t, from, to ); break;
+					case Robot_type::GREEN:	move_kernel< Robot_type::GREEN >( g, t, from, to ); break;
+					case Robot_type::BLUE:	move_kernel< Robot_type::BLUE >( g, t, from, to ); break;
+				}
+			} );
+		}
+		for ( auto &g : groups ) {
+			double step = 0;
+			for ( std::size_t i = 0; i < g.size(); ++i ) {
+				double dx = g.next_x[i] - g.x[i], dy = g.next_y[i] - g.y[i], dz = g.next_z[i] - g.z[i];
+				step = std::max( step, dx*dx + dy*dy + dz*dz );
+			}
+			travel[ g.type ] += std::sqrt( step );
+			std::swap( g.x, g.next_x );
+			std::swap( g.y, g.next_y );
+			std::swap( g.z, g.next_z );
+		}
+	}
+
 	void destroy_robots() {
-		std::set<robot*> to_destroy;
-		for ( auto &r : robots ) {
-			for ( auto &o : robots ) {
-				if ( r->can_attack( o.get() ) && euclid_dist( r->pos, o->pos ) <= DEATH_DIST ) {
-					to_destroy.insert( o.get() );
+		dead.assign( slot.size(), 0 );
+		grid.rebuild( groups );
+		for ( auto &g : groups ) {
+			Robot_type enemy = get_enemy_type( g.type );
+			std::size_t count = pieces( g.size() ).first;
+			victims.resize( std::max( victims.size(), count ) );
+			for ( std::size_t k = 0; k < count; ++k ) victims[k].clear();
+			parallel_for( g.size(), [ & ]( std::size_t k, std::size_t from, std::size_t to ) {
+				for ( std::size_t i = from; i < to; ++i ) {
+					grid.for_victims( enemy, g.pos( i ), g.player[i], [ & ]( robot_id v ) { victims[k].push_back( v ); } );
 				}
+			} );
+			for ( std::size_t k = 0; k < count; ++k ) {
+				for ( robot_id v : victims[k] ) dead[v] = 1;
 			}
 		}
-		for ( auto &r : robots ) {
-			if ( to_destroy.count( r->target ) ) r->target = nullptr;
+		for ( auto &g : groups ) {
+			for ( auto &t : g.target ) {
+				if ( t != no_robot && dead[t] ) t = no_robot;
+			}
 		}
-		for ( auto it = robots.begin(); it != robots.end(); ) {
-			if ( to_destroy.count( it->get() ) ) {
-				--get_robot_count( (*it)->player_id, (*it)->type );
-				it = robots.erase( it );
-			} else {
-				++it;
+		for ( auto &g : groups ) {
+			for ( std::size_t i = 0; i < g.size(); ++i ) {
+				if ( dead[ g.id[i] ] ) count_robot( g.player[i], g.type, -1 );
 			}
+			g.remove( dead );
+			for ( std::size_t i = 0; i < g.size(); ++i ) slot[ g.id[i] ] = i;
 		}
 	}
 
 	void tick() {
-		for ( auto &r : robots ) {
-			r->find_target( robots );
-			r->get_next_pos();
-		}
-		for ( auto &r : robots ) { r->move(); }
+		grid.rebuild( groups );
+		find_targets();
+		move_robots();
 		destroy_robots();
 	}
 
@@ -314,18 +754,16 @@ struct game {
 		return { ticks, get_sorted_players() };
 	}
 
-	void add_red( 	position start, int player_id ) {
-		robots.insert( std::make_unique<robot_red>( player_id, start ) );
-		++std::get<0>( players[player_id] );
-	}
-	void add_green( position start, int player_id ) {
-		robots.insert( std::make_unique<robot_green>( player_id, start ) );
-		++std::get<1>( players[player_id] );
-	}
-	void add_blue( 	position start, int player_id ) {
-		robots.insert( std::make_unique<robot_blue>( player_id, start ) );
-		++std::get<2>( players[player_id] );
+	void add( Robot_type type, position start, int player_id ) {
+		robot_group &g = group( type );
+		slot.push_back( g.size() );
+		g.add( slot.size() - 1, player_id, start );
+		added = true;
+		count_robot( player_id, type, 1 );
 	}
+	void add_red( 	position start, int player_id ) { add( Robot_type::RED, start, player_id ); }
+	void add_green( position start, int player_id ) { add( Robot_type::GREEN, start, player_id ); }
+	void add_blue( 	position start, int player_id ) { add( Robot_type::BLUE, start, player_id ); }
 };
 
 void test_small() {
@@ -457,6 +895,293 @@ void test_small_114() {
     assert( ticks == 114 );
 }
 
+//	a game of n robots of random types and owners scattered in a cube of the given side
+game random_game( int n, double side, unsigned seed ) {
+	std::mt19937 gen( seed );
+	std::uniform_real_distribution< double > coord( -side / 2, side / 2 );
+	std::uniform_int_distribution< int > kind( 0, 2 ), owner( 1, 4 );
+	game g;
+	for ( int i = 0; i < n; ++i ) {
+		position p{ coord( gen ), coord( gen ), coord( gen ) };
+		int k = kind( gen ), id = owner( gen );
+		if ( k == 0 ) g.add_red( p, id );
+		else if ( k == 1 ) g.add_green( p, id );
+		else g.add_blue( p, id );
+	}
+	return g;
+}
+
+//	the nearest enemy as found by a scan over the whole group
+robot_id scan_nearest( const game &g, Robot_type type, position from, int player ) {
+	const robot_group &enemies = g.groups[ type ];
+	robot_id best = no_robot;
+	for ( std::size_t i = 0; i < enemies.size(); ++i ) {
+		if ( enemies.player[i] != player && ( best == no_robot ||
+				euclid_dist( from, enemies.pos( i ) ) < euclid_dist( from, enemies.pos( g.slot[ best ] ) ) ) ) {
+			best = enemies.id[i];
+		}
+	}
+	return best;
+}
+
+void test_grid() {
+	std::cout << "TEST: GRID" << std::endl;
+	double inf = std::numeric_limits< double >::infinity();
+	for ( auto [ n, side ] : { std::pair{ 300, 20.0 }, { 300, 400.0 }, { 1000, 1.0 }, { 50, 5000.0 } } ) {
+		game g = random_game( n, side, n );
+		for ( int t = 0; t < 20; ++t ) {
+			g.grid.rebuild( g.groups );
+			for ( auto &r : g.groups ) {
+				Robot_type enemy = get_enemy_type( r.type );
+				for ( std::size_t i = 0; i < r.size(); ++i ) {
+					position from = r.pos( i );
+					auto [ best, runner_up ] = g.grid.search( enemy, from, r.player[i] );
+					assert( best == scan_nearest( g, enemy, from, r.player[i] ) );
+
+					std::set< robot_id > near, expect;
+					g.grid.for_victims( enemy, from, r.player[i], [ & ]( robot_id v ) { near.insert( v ); } );
+					const robot_group &o = g.groups[ enemy ];
+					std::vector< double > dists{ inf, inf };
+					for ( std::size_t j = 0; j < o.size(); ++j ) {
+						if ( o.player[j] != r.player[i] ) dists.push_back( euclid_dist( from, o.pos( j ) ) );
+						if ( o.player[j] != r.player[i] && euclid_dist( from, o.pos( j ) ) <= DEATH_DIST ) {
+							expect.insert( o.id[j] );
+						}
+					}
+					assert( near == expect );
+					std::nth_element( dists.begin(), dists.begin() + 1, dists.end() );
+					assert( runner_up == dists[ 1 ] );
+				}
+			}
+			g.tick();
+		}
+	}
+
+	// robots on the same spot are tied, the first one created wins
+	game g;
+	g.add_red( { 0, 0, 0 }, 1 );
+	for ( int i = 0; i < 10; ++i ) g.add_green( { 3, 4, 0 }, 2 );
+	g.grid.rebuild( g.groups );
+	assert( g.grid.nearest( Robot_type::GREEN, { 0, 0, 0 }, 1 ) == 1 );
+	assert( scan_nearest( g, Robot_type::GREEN, { 0, 0, 0 }, 1 ) == 1 );
+
+	// fewer robots than cells in a shell, the runner-up is not the nearest again
+	game h;
+	h.add_red( { 0, 0, 0 }, 1 );
+	for ( double x : { 0.5, 58.0, 88.0 } ) h.add_green( { x, 0, 0 }, 2 );
+	h.grid.rebuild( h.groups );
+	assert( h.grid.search( Robot_type::GREEN, { 0, 0, 0 }, 1 ) == std::pair( robot_id( 1 ), 58.0 ) );
+}
+
+//	the kernels against the rules of the object version, one robot at a time
+void test_move_kernels() {
+	std::cout << "TEST: MOVE KERNELS" << std::endl;
+	std::mt19937 gen( 7 );
+	std::uniform_real_distribution< double > coord( -30, 30 );
+	for ( Robot_type type : { Robot_type::RED, Robot_type::GREEN, Robot_type::BLUE } ) {
+		robot_group g( type );
+		target_positions t;
+		for ( int n = 0; n < 101; ++n ) {
+			position p{ coord( gen ), coord( gen ), coord( gen ) };
+			g.add( n, 1, p );
+			auto [ x, y, z ] = n % 5 == 0 ? p : n % 5 == 1 ? p + position{ 0, 0, EPSILON / 2 }
+										   : position{ coord( gen ), coord( gen ), coord( gen ) };
+			t.x.push_back( x ); t.y.push_back( y ); t.z.push_back( z );
+			t.dist.push_back( euclid_dist( p, { x, y, z } ) );
+			t.has.push_back( n % 7 == 3 ? 0 : -1 );
+		}
+		robot_group before = g;
+		g.next_x.resize( g.size() ); g.next_y.resize( g.size() ); g.next_z.resize( g.size() );
+		if ( type == Robot_type::RED ) move_kernel< Robot_type::RED >( g, t, 0, g.size() );
+		if ( type == Robot_type::GREEN ) move_kernel< Robot_type::GREEN >( g, t, 0, g.size() );
+		if ( type == Robot_type::BLUE ) move_kernel< Robot_type::BLUE >( g, t, 0, g.size() );
+
+		for ( std::size_t i = 0; i < g.size(); ++i ) {
+			position pos = before.pos( i ), to{ t.x[i], t.y[i], t.z[i] }, next = pos;
+			position last{ before.dir_x[i], before.dir_y[i], before.dir_z[i] };
+			bool aimed = t.has[i];
+			if ( type == Robot_type::RED && aimed )
+				next = pos + unit_direction( pos, to )*base_speed*TICK_SIZE;
+			if ( type == Robot_type::GREEN && aimed )
+				next = euclid_dist( pos, to ) > 10 ? to + unit_direction( pos, to )*8
+												   : pos + unit_direction( pos, to )*base_speed*TICK_SIZE;
+			if ( type == Robot_type::BLUE && aimed ) {
+				last = unit_direction( pos, to );
+				next = pos + last*base_speed*TICK_SIZE;
+			}
+			if ( type == Robot_type::BLUE && !aimed )
+				next = pos + last*(base_speed/2.0)*TICK_SIZE;
+			// == on doubles on purpose, the kernels must not round differently
+			assert(( next == position{ g.next_x[i], g.next_y[i], g.next_z[i] } ));
+			if ( type == Robot_type::BLUE )
+				assert(( last == position{ g.dir_x[i], g.dir_y[i], g.dir_z[i] } ));
+		}
+	}
+}
+
+//	every position of every live robot, by id
+std::map< robot_id, position > snapshot( const game &g ) {
+	std::map< robot_id, position > res;
+	for ( auto &gr : g.groups ) {
+		for ( std::size_t i = 0; i < gr.size(); ++i ) res[ gr.id[i] ] = gr.pos( i );
+	}
+	return res;
+}
+
+void test_threads() {
+	std::cout << "TEST: THREADS" << std::endl;
+	auto large = []( game &g ) {
+		for ( auto [ x, id ] : { std::pair{ 150.0, 1 }, { -150.0, 2 } } ) {
+			g.add_red( { x, 0, 0 }, id );
+			g.add_green( { x, 0, 0 }, id );
+			g.add_blue( { x, 0, 0 }, id );
+		}
+	};
+	auto small_114 = []( game &g ) {
+		g.add_red( { -14, -1, 1 }, -1 );
+		g.add_green( { -14, -1, -1 }, 0 );
+		g.add_green( { 1, -1, -1 }, 0 );
+		g.add_green( { 1, -1, -1 }, -1 );
+		g.add_blue( { 1, -1, 0 }, -1 );
+		g.add_blue( { 1, -1, 0 }, -1 );
+	};
+
+	for ( unsigned threads : { 2, 3, 8 } ) {
+		for ( std::size_t grain : { 1, 7 } ) {
+			game a, b;
+			large( a ); large( b );
+			b.threads = threads;
+			b.parallel_grain = grain;
+			assert( a.run() == b.run() );
+			assert( snapshot( a ) == snapshot( b ) );
+
+			game c, d;
+			small_114( c ); small_114( d );
+			d.threads = threads;
+			d.parallel_grain = grain;
+			assert( c.run() == d.run() );
+
+			// tick by tick, the positions are the same bit for bit
+			game e = random_game( 600, 40, threads ), f = random_game( 600, 40, threads );
+			e.threads = 1;
+			f.threads = threads;
+			f.parallel_grain = grain;
+			worker_pool *pool = nullptr;
+			for ( int t = 0; t < 50; ++t ) {
+				e.tick();
+				f.tick();
+				assert( snapshot( e ) == snapshot( f ) );
+				assert( e.players == f.players );
+				if ( t == 0 ) pool = f.pool.get();
+			}
+			// the workers are started once and kept between the ticks
+			assert( !e.pool && pool && f.pool.get() == pool && pool->size() == threads - 1 );
+		}
+	}
+}
+
+//	the end of the game as the original check over all pairs of robots saw it
+bool scan_game_end( const game &g ) {
+	for ( auto &r : g.groups ) {
+		const robot_group &enemies = g.groups[ get_enemy_type( r.type ) ];
+		for ( int p : r.player ) {
+			for ( int q : enemies.player ) {
+				if ( p != q ) return false;
+			}
+		}
+	}
+	return true;
+}
+
+void test_game_end() {
+	std::cout << "TEST: GAME END" << std::endl;
+	game g;
+	assert( g.game_end() );
+	g.add_red( { 0, 0, 0 }, 1 );
+	g.add_green( { 5, 0, 0 }, 1 );
+	assert( g.game_end() );			// a single player
+	g.add_red( { 20, 0, 0 }, 2 );
+	g.add_red( { 25, 0, 0 }, 3 );
+	assert( !g.game_end() );		// the new reds can attack the green
+	assert( scan_game_end( g ) == g.game_end() );
+
+	game h;
+	h.add_red( { 0, 0, 0 }, 1 );
+	h.add_red( { 20, 0, 0 }, 2 );
+	assert( h.game_end() );			// red does not attack red
+	h.add_blue( { 30, 0, 0 }, 2 );
+	assert( !h.game_end() );		// the blue can attack the red of player 1
+	assert( scan_game_end( h ) == h.game_end() );
+
+	for ( int seed = 1; seed <= 30; ++seed ) {
+		game r = random_game( 10 + seed * 4, 5 + seed * 2, seed );
+		while ( true ) {
+			assert( r.game_end() == scan_game_end( r ) );
+			for ( auto &gr : r.groups ) {
+				for ( std::size_t i = 0; i < gr.size(); ++i ) assert( r.get_robot_count( gr.player[i], gr.type ) > 0 );
+			}
+			if ( r.game_end() ) break;
+			r.tick();
+		}
+	}
+}
+
+void test_target_cache() {
+	std::cout << "TEST: TARGET CACHE" << std::endl;
+	for ( auto [ n, side ] : { std::pair{ 400, 30.0 }, { 400, 300.0 }, { 100, 8.0 } } ) {
+		game a = random_game( n, side, n ), b = random_game( n, side, n );
+		b.target_cache = false;
+		std::size_t kept = 0;
+		for ( int t = 0; t < 200; ++t ) {
+			for ( auto &g : a.groups ) {
+				for ( std::size_t i = 0; i < g.size(); ++i ) kept += g.type != Robot_type::RED && a.target_holds( g, i );
+			}
+			if ( t == 100 ) {
+				// a newcomer may be nearer than any cached target
+				a.add_blue( { 0, 0, 0 }, 9 );
+				b.add_blue( { 0, 0, 0 }, 9 );
+			}
+			a.tick();
+			b.tick();
+			assert( snapshot( a ) == snapshot( b ) );
+			for ( auto type : { Robot_type::RED, Robot_type::GREEN, Robot_type::BLUE } ) {
+				assert( a.groups[ type ].target == b.groups[ type ].target );
+			}
+		}
+		assert( kept > 0 );
+		assert( a.players == b.players );
+	}
+}
+
+void bench_grid() {
+	std::cout << "BENCH: GRID" << std::endl;
+	for ( int n : { 1000, 5000, 20000, 50000 } ) {
+		// the same density for all the counts, the first ticks are the busy ones
+		game g = random_game( n, 10 * std::cbrt( n ), 1 );
+		const int ticks = 10;
+		auto start = std::chrono::steady_clock::now();
+		for ( int t = 0; t < ticks; ++t ) g.tick();
+		std::chrono::duration< double > took = std::chrono::steady_clock::now() - start;
+		std::size_t left = 0;
+		for ( auto &gr : g.groups ) left += gr.size();
+		std::cout << n << " robots: " << ticks / took.count() << " ticks/s, "
+				  << left << " left" << std::endl;
+	}
+}
+
+void bench_threads() {
+	std::cout << "BENCH: THREADS" << std::endl;
+	for ( unsigned threads : { 1, 2, 4, 8 } ) {
+		game g = random_game( 50000, 10 * std::cbrt( 50000 ), 1 );
+		g.threads = threads;
+		const int ticks = 10;
+		auto start = std::chrono::steady_clock::now();
+		for ( int t = 0; t < ticks; ++t ) g.tick();
+		std::chrono::duration< double > took = std::chrono::steady_clock::now() - start;
+		std::cout << threads << " threads: " << ticks / took.count() << " ticks/s" << std::endl;
+	}
+}
+
 int main()
 {
     /*
@@ -493,6 +1218,14 @@ int main()
 	test_3ticks();
 	test_verity_large();
 	test_verity_small();
+	test_grid();
+	test_move_kernels();
+	test_threads();
+	test_game_end();
+	test_target_cache();
+
+	//bench_grid();
+	//bench_threads();
 	
     return 0;
 }
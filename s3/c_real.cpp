@@ -5,6 +5,8 @@
 #include <algorithm>
 #include <tuple>
 #include <cmath>
+#include <climits>
+#include <chrono>
 
 /* Předmětem této úlohy je naprogramovat typ ‹real›, který
  * reprezentuje reálné číslo s libovolnou přesností a rozsahem.
@@ -221,24 +223,73 @@ natural operator*( const natural &a, const natural &b ) {
 	return res;	
 }
 
-void operator<<=( natural &n, int off ) {
-	n.add_digits(1);
-	for ( auto i = n.digit_count(); i > 1; --i ) {
-		n[i-1] = ( n[i-1] << off ) | ( n[i-2] >> (8-off) );	
+std::size_t bit_count( const natural &n ) {
+	std::size_t bits = 8 * ( n.digit_count() - 1 );
+	for ( std::uint8_t top = n[ n.digit_count()-1 ]; top; top >>= 1 ) ++bits;
+	return bits;
+}
+
+/* Shifts by any number of bits in a single pass: whole digits move by
+ * the index offset, and each digit of the result combines the two
+ * neighbouring source digits. */
+
+natural &operator<<=( natural &n, std::size_t bits ) {
+	std::size_t k = bits / 8, s = bits % 8, size = n.digit_count();
+	n._digits.resize( size + k + 1 );
+	for ( std::size_t i = size + k + 1; i-- > k; ) {
+		std::uint8_t hi = ( i - k < size ) ? n[ i-k ] : 0,
+					 lo = ( i > k ) ? n[ i-k-1 ] : 0;
+		n[i] = ( hi << s ) | ( lo >> ( 8 - s ) );
 	}
-	n[0] = n[0] << off;
+	std::fill( n._digits.begin(), n._digits.begin() + k, 0 );
 	n.remove_zero_digits();
+	return n;
 }
-void operator>>=( natural &n, int off ) {
-	for ( std::size_t i = 0; i < n.digit_count()-1; ++i ) {
-		n[i] = ( n[i] >> off ) | ( n[i+1] << (8-off) );
+natural &operator>>=( natural &n, std::size_t bits ) {
+	std::size_t k = bits / 8, s = bits % 8, size = n.digit_count();
+	if ( k >= size ) {
+		n._digits.assign( 1, 0 );
+		return n;
 	}
-	n[ n.digit_count()-1 ] = n[ n.digit_count()-1 ] >> off;
+	for ( std::size_t i = 0; i + k < size; ++i ) {
+		std::uint8_t hi = ( i + k + 1 < size ) ? n[ i+k+1 ] : 0;
+		n[i] = ( n[ i+k ] >> s ) | ( hi << ( 8 - s ) );
+	}
+	n._digits.resize( size - k );
 	n.remove_zero_digits();
+	return n;
+}
+
+//	a -= b · 2ᵇⁱᵗˢ unless that would go below zero, with the digits of
+//	the shifted b computed on the fly
+bool sub_shifted( natural &a, const natural &b, std::size_t bits ) {
+	if ( b == natural( 0 ) ) return true;
+	std::size_t k = bits / 8, s = bits % 8;
+	auto digit = [&]( std::size_t i ) -> std::uint8_t {
+		if ( i < k ) return 0;
+		std::uint8_t hi = ( i - k < b.digit_count() ) ? b[ i-k ] : 0,
+					 lo = ( i > k && i - k - 1 < b.digit_count() ) ? b[ i-k-1 ] : 0;
+		return ( hi << s ) | ( lo >> ( 8 - s ) );
+	};
+	std::size_t len = ( bit_count( b ) + bits + 7 ) / 8;
+	if ( len > a.digit_count() ) return false;
+	for ( std::size_t i = len; len == a.digit_count() && i > 0; --i ) {
+		if ( a[i-1] != digit( i-1 ) ) {
+			if ( a[i-1] < digit( i-1 ) ) return false;
+			break;
+		}
+	}
+	std::uint16_t borrow = 0;
+	for ( std::size_t i = k; i < len || ( borrow && i < a.digit_count() ); ++i ) {
+		std::uint16_t r = a[i] - digit( i ) - borrow;
+		a[i] = r & 255;
+		borrow = ( r >> 8 ) & 1;
+	}
+	a.remove_zero_digits();
+	return true;
 }
 
 std::uint8_t short_div( auto &it_start, auto &it_end, const natural &denom ) {
-	natural den = denom;
 	std::vector<std::uint8_t> nomvec(it_start, it_end);
 	std::reverse( nomvec.begin(), nomvec.end() );
 	natural nom( nomvec );
@@ -246,13 +297,8 @@ std::uint8_t short_div( auto &it_start, auto &it_end, const natural &denom ) {
 		return 0;
 	}
 	std::uint8_t res = 0;
-	den <<= 7;
-	for ( int bit_off = 0; bit_off < 8; ++bit_off ) {
-		if ( den <= nom ) {
-			nom = nom - den;
-			res = res | ( 1 << (7-bit_off) );
-		}
-		den >>= 1;
+	for ( int bit_off = 7; bit_off >= 0; --bit_off ) {
+		if ( sub_shifted( nom, denom, bit_off ) ) res |= 1 << bit_off;
 	}
 
 	auto it = it_start;
@@ -318,6 +364,76 @@ natural natural::power( int p ) {
 	return base*res;
 }
 
+std::size_t trailing_zero_bits( const natural &n ) {
+	std::size_t bits = 0, i = 0;
+	while ( i + 1 < n.digit_count() && n[i] == 0 ) { ++i; bits += 8; }
+	for ( std::uint8_t d = n[i]; d && !( d & 1 ); d >>= 1 ) ++bits;
+	return bits;
+}
+
+bool is_power_of_two( const natural &n ) {
+	return trailing_zero_bits( n ) + 1 == bit_count( n );
+}
+
+//	multiplication which only shifts when one of the factors is a power of
+//	two – as are the denominators of the rounded ( dyadic ) values below
+natural times( const natural &a, const natural &b ) {
+	if ( !is_power_of_two( b ) ) {
+		return is_power_of_two( a ) ? times( b, a ) : a * b;
+	}
+	natural res = a;
+	res <<= trailing_zero_bits( b );
+	return res;
+}
+
+//	b = b - a with the trailing zero bits shifted out, in a single pass:
+//	once the lowest non-zero digit of the difference fixes the shift,
+//	each further digit is written back shifted, right behind the reads
+void sub_shift_right( natural &b, const natural &a ) {
+	assert( a <= b );
+	std::size_t size = b.digit_count(), zeros = 0, s = 0;
+	std::int16_t borrow = 0;
+	std::uint8_t prev = 0;
+	bool found = false;
+	for ( std::size_t i = 0; i < size; ++i ) {
+		std::int16_t d = b[i] - ( i < a.digit_count() ? a[i] : 0 ) - borrow;
+		borrow = d < 0;
+		std::uint8_t dig = d & 255;
+		if ( found ) {
+			b[ i-zeros-1 ] = ( prev >> s ) | ( dig << ( 8 - s ) );
+		} else if ( dig ) {
+			found = true;
+			for ( std::uint8_t t = dig; !( t & 1 ); t >>= 1 ) ++s;
+		} else {
+			++zeros;
+			continue;
+		}
+		prev = dig;
+	}
+	if ( !found ) {
+		b._digits.assign( 1, 0 );
+		return;
+	}
+	b[ size-zeros-1 ] = prev >> s;
+	b._digits.resize( size - zeros );
+	b.remove_zero_digits();
+}
+
+// binary ( Stein's ) algorithm - only subtractions and shifts, no divisions
+natural gcd( natural a, natural b ) {
+	if ( a == natural( 0 ) ) return b;
+	if ( b == natural( 0 ) ) return a;
+	std::size_t a_twos = trailing_zero_bits( a ), b_twos = trailing_zero_bits( b );
+	a >>= a_twos;
+	b >>= b_twos;
+	while ( b != natural( 0 ) && a != natural( 1 ) ) {		// both odd here
+		if ( a > b ) std::swap( a, b );
+		sub_shift_right( b, a );
+	}
+	a <<= std::min( a_twos, b_twos );
+	return a;
+}
+
 // ================ REAL =====================
 
 /* Předmětem této úlohy je naprogramovat typ ‹real›, který
@@ -366,48 +482,109 @@ natural natural::power( int p ) {
  * konverzemi, je vhodné označit konverzní konstruktory a operátory
  * pro hodnoty typu ‹double› klíčovým slovem ‹explicit›. */
 
+/* The fraction _p / _q is not reduced after every operation: the
+ * number of operations since the last reduction is kept in _pending
+ * and once it reaches ‹normalize_period›, both parts are divided by
+ * their gcd. This keeps the operands of iterated computations (like
+ * the series below) bounded, without paying a gcd for every step. */
+
 struct real {
+	static inline int normalize_period = 4;		// 1 = reduce eagerly
+
 	bool _sign = false;		// false = positive, true = negative
 	natural _p, _q;
+	int _pending = 0;
+
+	//	|v| as a natural, negated as unsigned so that INT_MIN works too
+	static natural magnitude( int v ) {
+		unsigned m = v < 0 ? 0u - unsigned( v ) : unsigned( v );
+		std::vector< std::uint8_t > digits;
+		do {
+			digits.push_back( m & 255 );
+			m >>= 8;
+		} while ( m );
+		return natural( digits );
+	}
 
-	real( bool sgn, const natural &p, const natural &q ) : _sign( sgn ), _p( p ), _q( q ) {}
+	real( int v ) : _sign( v < 0 ), _p( magnitude( v ) ), _q( 1 ) {}
+	explicit real( double d ) : _sign( d < 0 ), _q( 1 ) {
+		int exp = 0;
+		double mant = std::ldexp( std::frexp( std::fabs( d ), &exp ), 53 );
+		exp -= 53;
+		_p = natural( mant );
+		if ( exp > 0 ) _p <<= exp;
+		if ( exp < 0 ) _q = natural( 2 ).power( -exp );
+		normalize();
+	}
+	real( bool sgn, const natural &p, const natural &q, int pending = 0 ) 
+		: _sign( sgn ), _p( p ), _q( q ), _pending( pending ) {
+		if ( _p == natural( 0 ) ) _sign = false;
+		if ( _pending >= normalize_period ) normalize();
+	}
+
+	void normalize() {
+		natural g = gcd( _p, _q );
+		std::size_t twos = trailing_zero_bits( g );
+		if ( twos + 1 == bit_count( g ) ) {		// a power of two, only shift
+			_p >>= twos;
+			_q >>= twos;
+		} else {
+			_p = _p / g;
+			_q = _q / g;
+		}
+		_pending = 0;
+	}
+
+	//	pending operations of a result computed from x and y
+	friend int pending( const real &x, const real &y ) {
+		return std::max( x._pending, y._pending ) + 1;
+	}
 
-	real reciprocal() const { return real( _sign, _q, _p ); }
-	real abs() const { 		  return real( false, _p, _q ); }
+	real reciprocal() const { return real( _sign, _q, _p, _pending ); }
+	real abs() const { 		  return real( false, _p, _q, _pending ); }
 
 	friend real operator+( const real &x, const real &y ) {
-		
+		if ( x._q == y._q ) return add( x, y, x._p, y._p, x._q );
+		return add( x, y, times( x._p, y._q ), times( y._p, x._q ), times( x._q, y._q ) );
 	}
-	friend real operator-( const real &x ) { return real( !x._sign, x._p, x._q ); }
+	//	adds the numerators xp, yp of x and y over the common denominator q
+	friend real add( const real &x, const real &y, 
+					 const natural &xp, const natural &yp, const natural &q ) {
+		if ( x._sign == y._sign ) return real( x._sign, xp + yp, q, pending( x, y ) );
+		if ( xp >= yp ) 		  return real( x._sign, xp - yp, q, pending( x, y ) );
+		return real( y._sign, yp - xp, q, pending( x, y ) );
+	}
+	friend real operator-( const real &x ) { return real( !x._sign, x._p, x._q, x._pending ); }
 	friend real operator-( const real &x, const real &y ) { return x + ( -y ); }
 	friend real operator*( const real &x, const real &y ) {
-		return real( x._sign != y._sign, x._p * y._p, x._q * y._q );
+		return real( x._sign != y._sign, times( x._p, y._p ), times( x._q, y._q ), pending( x, y ) );
 	}
 	friend real operator/( const real &x, const real &y ) {
-		return real( x._sign != y._sign, x._p * y._q, x._q * y._p );
-	}
-	
-	void set( bool sgn, const real &p, const real &q ) {
-		_sign = sgn; _p = p; _q = q;
+		return real( x._sign != y._sign, times( x._p, y._q ), times( x._q, y._p ), pending( x, y ) );
 	}
-	// maybe this first and then a + b  == real(a); a+=b
-	real &operator+=( const real &x ) { return *this; }
-	real &operator-=( const real &x ) { return *this; }
-	real &operator*=( const real &x ) { return *this; }
-	real &operator/=( const real &x ) { return *this; }
+
+	real &operator+=( const real &x ) { return *this = *this + x; }
+	real &operator-=( const real &x ) { return *this = *this - x; }
+	real &operator*=( const real &x ) { return *this = *this * x; }
+	real &operator/=( const real &x ) { return *this = *this / x; }
 
 	friend bool operator==( const real &x, const real &y ) {
-		return ( x._sign == y._sign ) && ( x._p * y._q == x._q * y._p );
+		return ( x._sign == y._sign ) && ( times( x._p, y._q ) == times( x._q, y._p ) );
 	}
 	friend bool operator!=( const real &x, const real &y ) { return !( x == y ); }
 	friend bool operator<( const real &x, const real &y ) {
-		return 
+		if ( x._sign != y._sign ) return x._sign;
+		if ( x._sign ) return times( y._p, x._q ) < times( x._p, y._q );
+		return times( x._p, y._q ) < times( y._p, x._q );
 	}
 	friend bool operator<=( const real &x, const real &y ) { return x < y || x == y; }
 	friend bool operator>( const real &x, const real &y )  { return y < x; }
 	friend bool operator>=( const real &x, const real &y ) { return y < x || x == y; }
 
-	real power( int k ) const {}
+	real power( int k ) const {
+		if ( k < 0 ) return reciprocal().power( -k );
+		return real( _sign && k % 2, natural( _p ).power( k ), natural( _q ).power( k ), _pending );
+	}
 
 
  /* Přesností p se myslí absolutní hodnota rozdílu skutečné (přesné) a
@@ -420,20 +597,388 @@ struct real {
  * na situace, kdy členy posloupnosti nejprve rostou a až poté se
  * začnou zmenšovat. */
  
- 	/*real sqrt( const real &p ) const {
-		// TODO: Newtonova-Raphsonova metoda
- 	}
- 	real exp( const real &p ) const {
- 		real r = *this, //r_prev = real( 0 );
-		while( abs( r, r_prev ) > p ) {
-			r_prev = r;
-			// TODO: do magic with r
-		}
- 		return r; 		
- 	}
- 	real log1p( const real &p ) const {}*/
+	real sqrt( const real &p ) const;
+	real reciprocal( const real &p ) const;
+	real exp( const real &p ) const;
+	real log1p( const real &p ) const;
 };
 
+// ================ SERIES =====================
+
+natural power_of_two( std::size_t k ) {
+	natural n( 1 );
+	n <<= k;
+	return n;
+}
+
+//	t such that 2⁻ᵗ ≤ p ( at least 1 )
+std::size_t precision_bits( const real &p ) {
+	std::size_t p_bits = bit_count( p._p ), q_bits = bit_count( p._q );
+	return ( q_bits + 1 > p_bits + 1 ) ? q_bits + 1 - p_bits : 1;
+}
+
+/* The results of the series are rounded to a fixed number of binary
+ * places – the exact partial sums would otherwise grow with every
+ * squaring of the argument reduction. */
+
+//	the nearest multiple of 2⁻ᵇⁱᵗˢ towards zero
+real round_bits( const real &x, std::size_t bits ) {
+	natural n = x._p;
+	std::size_t q_twos = trailing_zero_bits( x._q );
+	if ( q_twos + 1 == bit_count( x._q ) ) {		// dyadic already, only shift
+		if ( q_twos > bits ) n >>= q_twos - bits;
+		if ( q_twos < bits ) n <<= bits - q_twos;
+		return real( x._sign, n, power_of_two( bits ) );
+	}
+	n <<= bits;
+	return real( x._sign, n / x._q, power_of_two( bits ) );
+}
+
+/* Binary splitting: for the terms ∏_{l < j ≤ k} p(j) / q(j) with
+ * l < k ≤ r, computes P = ∏ p(j), Q = ∏ q(j) and T such that the
+ * terms add up to T / Q. The halves of the range are combined in a
+ * balanced tree, so the big products are between operands of similar
+ * size instead of one growing sum times a small term. */
+
+struct split_sum {
+	natural p, q, t;
+};
+
+template< typename p_fn, typename q_fn >
+split_sum binary_split( int l, int r, const p_fn &p, const q_fn &q ) {
+	if ( r - l == 1 ) return { p( r ), q( r ), p( r ) };
+	int m = ( l + r ) / 2;
+	split_sum left = binary_split( l, m, p, q ), right = binary_split( m, r, p, q );
+	return { left.p * right.p, left.q * right.q, left.t * right.q + left.p * right.t };
+}
+
+//	n mod 2ᵇⁱᵗˢ
+natural low_bits( const natural &n, std::size_t bits ) {
+	std::size_t digs = std::min( ( bits + 7 ) / 8, n.digit_count() );
+	natural res( std::vector<std::uint8_t>( n._digits.begin(), n._digits.begin() + digs ) );
+	if ( bits % 8 && digs == ( bits + 7 ) / 8 ) res[ digs-1 ] &= ( 1 << ( bits % 8 ) ) - 1;
+	res.remove_zero_digits();
+	return res;
+}
+
+//	exp( a / 2ᵉ ) for a / 2ᵉ < 2⁻ˢ ≤ 1/2, rounded to the given number of places
+real exp_series( const natural &a, std::size_t e, std::size_t s, std::size_t bits ) {
+	int n = 1;		// the first omitted term is below 2⁻ˢ⁽ⁿ⁺¹⁾ / ( n + 1 )!
+	for ( double term_bits = 2.0 * s + 1; term_bits < bits + 2; ++n ) {
+		term_bits += s + std::log2( n + 2 );
+	}
+	natural den = power_of_two( e );
+	split_sum sum = binary_split( 0, n, [&]( int ) { return a; }, 
+										[&]( int j ) { return natural( j ) * den; } );
+	return round_bits( real( false, sum.q + sum.t, sum.q ), bits );
+}
+
+/* exp( x ) = exp( x / 2ᵏ )^( 2ᵏ ) with k chosen so that the reduced
+ * argument is below 1/2 – the working precision accounts for the error
+ * doubling with each squaring and for the magnitude of the result.
+ * The reduced argument is then split into chunks of bits at places
+ * ( 16, 32 ], ( 32, 64 ], … – the series for a chunk with numerator of
+ * 2ⁱ bits needs only about t / 2ⁱ terms, so every chunk keeps the
+ * products of the binary splitting at about t bits (the «bit-burst»
+ * scheme). Negative arguments use exp( -x ) = 1 / exp( x ). */
+
+real real::exp( const real &p ) const {
+	if ( _sign ) return ( -*this ).exp( p ).reciprocal();
+	if ( _p == natural( 0 ) ) return 1;
+
+	std::size_t t = precision_bits( p );
+	std::size_t p_bits = bit_count( _p ), q_bits = bit_count( _q );
+	std::size_t x_bits = ( p_bits + 1 > q_bits ) ? p_bits + 1 - q_bits : 0;		// x < 2ˣ_ᵇⁱᵗˢ
+	std::size_t magnitude = ( std::size_t( 1 ) << std::min( x_bits, std::size_t( 40 ) ) ) * 3 / 2 + 1;
+	std::size_t k = x_bits + 1;
+	std::size_t bits = t + magnitude + k + 16;
+
+	natural x = round_bits( real( false, _p, _q * power_of_two( k ) ), bits )._p;
+	real y = 1;
+	for ( std::size_t low = 0, high = 16; low < bits; low = high, high *= 2 ) {
+		high = std::min( high, bits );
+		natural chunk = x;
+		chunk >>= bits - high;
+		chunk = low_bits( chunk, high - low );
+		if ( chunk == natural( 0 ) ) continue;
+		y = round_bits( y * exp_series( chunk, high, std::max( low, std::size_t( 1 ) ), bits ), bits );
+	}
+	for ( std::size_t i = 0; i < k; ++i ) {
+		y = round_bits( y * y, bits );
+	}
+	return round_bits( y, t + 2 );
+}
+
+double log2( natural n ) {
+	std::size_t drop = ( bit_count( n ) > 60 ) ? bit_count( n ) - 60 : 0;
+	n >>= drop;
+	return std::log2( n.to_double() ) + drop;
+}
+
+/* log( 1 + x ) = 2 atanh( y ) with y = x / ( 2 + x ), which leaves
+ * only the odd powers of y. Summed by binary splitting, so it is cheap
+ * only while y has a short numerator and denominator – the callers
+ * below pass either a small fraction, or y rounded to the given number
+ * of places and small enough ( |y| ≤ 0.172 ) for the number of terms
+ * to stay within bits / 2.5. */
+
+real atanh_series( const real &y, std::size_t bits ) {
+	if ( y._p == natural( 0 ) ) return 0;
+
+	double y_bits = 0.999 * ( log2( y._q ) - log2( y._p ) );		// |y| ≤ 2⁻ʸ_ᵇⁱᵗˢ
+	int n = std::max( 0, static_cast<int>( std::ceil( ( ( bits + 3 ) / y_bits - 3 ) / 2 ) ) );
+	natural a_sq = y._p * y._p, b_sq = y._q * y._q;
+	real sum( y._sign, y._p * natural( 2 ), y._q );
+	if ( n > 0 ) {
+		split_sum s = binary_split( 0, n, [&]( int j ) { return a_sq * natural( 2 * j - 1 ); },
+										  [&]( int j ) { return b_sq * natural( 2 * j + 1 ); } );
+		sum *= real( false, s.q + s.t, s.q );
+	}
+	return round_bits( sum, bits );
+}
+
+//	log( 1 + x ) for 1 + x ∈ [ 1/√2, √2 )
+real log1p_series( const real &x, std::size_t bits ) {
+	return atanh_series( round_bits( x / ( real( 2 ) + x ), bits + 4 ), bits );
+}
+
+//	log( 2 ) = 2 atanh( 1/3 )
+real ln2( std::size_t bits ) {
+	return atanh_series( real( 1 ) / 3, bits );
+}
+
+/* For 1 + x = 2ᵏ·m with m ∈ [ 1/√2, √2 ), log( 1 + x ) = k·log( 2 ) +
+ * log( m ), and only the latter goes through the series and Newton
+ * below – so the arguments near -1 cost no more than those near 0.
+ * The series gives the first 64 bits of log( m ), the rest comes from
+ * the Newton iteration z ← z + m·exp( -z ) - 1 for exp( z ) = m, which
+ * doubles the number of correct bits with every step – so each step
+ * runs at (roughly) twice the precision of the previous one, and the
+ * whole costs about two evaluations of exp at the final precision. */
+
+real real::log1p( const real &p ) const {
+	assert( abs() < real( 1 ) );
+	std::size_t t = precision_bits( p ) + 8;
+
+	real a = real( 1 ) + *this;
+	int k = static_cast<int>( std::lround( log2( a._p ) - log2( a._q ) ) );
+	real m = ( k >= 0 ) ? real( false, a._p, a._q * power_of_two( k ) )
+						: real( false, a._p * power_of_two( -k ), a._q );
+	real z = log1p_series( m - real( 1 ), std::min( t, std::size_t( 64 ) ) );
+
+	if ( t > 64 ) {
+		std::vector<std::size_t> steps;
+		for ( std::size_t prec = t; prec > 60; prec = prec / 2 + 8 ) steps.push_back( prec );
+		for ( auto prec = steps.rbegin(); prec != steps.rend(); ++prec ) {
+			real w = ( -z ).exp( real( false, natural( 1 ), power_of_two( *prec + 2 ) ) );
+			z = round_bits( z + m * w - real( 1 ), *prec );
+		}
+	}
+	if ( k != 0 ) z += real( k ) * ln2( t + bit_count( real::magnitude( k ) ) );
+	return round_bits( z, t - 6 );
+}
+
+// ================ NEWTON =====================
+
+/* Both iterations below avoid division: the inverse square root and
+ * the reciprocal of a scaled argument a' ∈ [ 1/4, 4 ) are refined from
+ * a double estimate, each step at twice the precision of the previous
+ * one, so that all the steps together cost about as much as a couple
+ * of multiplications at the final precision. The steps are listed
+ * from the final precision down, then run in the opposite order. */
+
+std::vector<std::size_t> newton_steps( std::size_t bits ) {
+	std::vector<std::size_t> steps;
+	for ( std::size_t prec = bits; prec > 40; prec = prec / 2 + 8 ) steps.push_back( prec );
+	std::reverse( steps.begin(), steps.end() );
+	return steps;
+}
+
+//	a = a' · 2ˢᶜᵃˡᵉ where a' ∈ [ 1/4, 4 ) and 2 divides scale if even is set
+std::tuple<real, int> scale_down( const real &a, bool even ) {
+	int scale = static_cast<int>( bit_count( a._p ) ) - static_cast<int>( bit_count( a._q ) );
+	if ( even ) scale -= ( ( scale % 2 ) + 2 ) % 2;
+	if ( scale >= 0 ) return { real( false, a._p, a._q * power_of_two( scale ) ), scale };
+	return { real( false, a._p * power_of_two( -scale ), a._q ), scale };
+}
+
+real times_power_of_two( const real &x, int scale ) {
+	if ( scale >= 0 ) return real( x._sign, x._p * power_of_two( scale ), x._q );
+	return real( x._sign, x._p, x._q * power_of_two( -scale ) );
+}
+
+//	y ← y + y·( 1 - a·y² ) / 2 converges to 1 / √a, then √a = a·y
+real real::sqrt( const real &p ) const {
+	assert( !_sign );
+	if ( _p == natural( 0 ) ) return 0;
+	auto [ a, scale ] = scale_down( *this, true );		// √x = √a · 2ˢᶜᵃˡᵉ ᐟ ²
+	int t = static_cast<int>( precision_bits( p ) );
+	std::size_t bits = std::max( t + scale / 2 + 6, 16 );
+
+	real y( 1 / std::sqrt( std::exp2( log2( a._p ) - log2( a._q ) ) ) );
+	for ( std::size_t prec : newton_steps( bits ) ) {
+		real a_prec = round_bits( a, prec + 4 );
+		real err = real( 1 ) - round_bits( a_prec * y * y, prec + 4 );
+		y = round_bits( y + y * err / 2, prec );
+	}
+	real root = round_bits( round_bits( a, bits + 4 ) * y, bits );
+	return round_bits( times_power_of_two( root, scale / 2 ), t + 2 );
+}
+
+//	y ← y + y·( 1 - a·y ) converges to 1 / a
+real real::reciprocal( const real &p ) const {
+	assert( _p != natural( 0 ) );
+	auto [ a, scale ] = scale_down( *this, false );		// 1 / x = 1 / a · 2⁻ˢᶜᵃˡᵉ
+	int t = static_cast<int>( precision_bits( p ) );
+	std::size_t bits = std::max( t - scale + 6, 16 );
+
+	real y( 1 / std::exp2( log2( a._p ) - log2( a._q ) ) );
+	for ( std::size_t prec : newton_steps( bits ) ) {
+		real err = real( 1 ) - round_bits( round_bits( a, prec + 4 ) * y, prec + 4 );
+		y = round_bits( y + y * err, prec );
+	}
+	real res = times_power_of_two( round_bits( y, bits ), -scale );
+	res._sign = _sign;
+	return round_bits( res, t + 2 );
+}
+
+natural parse( const char *digits ) {
+	natural res;
+	for ( ; *digits; ++digits ) res = res * natural( 10 ) + natural( *digits - '0' );
+	return res;
+}
+
+void test_gcd() {
+	std::cout << "TEST GCD" << std::endl;
+	assert( gcd( natural( 12 ), natural( 18 ) ) == natural( 6 ) );
+	assert( gcd( natural( 0 ), natural( 7 ) ) == natural( 7 ) );
+	assert( gcd( natural( 17 ), natural( 5 ) ) == natural( 1 ) );
+	natural a = natural( 2 ).power( 40 ) * natural( 3 ).power( 5 ) * natural( 7 );
+	natural b = natural( 2 ).power( 35 ) * natural( 3 ).power( 9 ) * natural( 11 );
+	assert( gcd( a, b ) == natural( 2 ).power( 35 ) * natural( 3 ).power( 5 ) );
+	natural c = natural( 3 ).power( 60 ), d = natural( 3 ).power( 60 ) - natural( 256 ).power( 5 );
+	assert( gcd( c, natural( 5 ).power( 30 ) ) == natural( 1 ) );
+	assert( gcd( c * natural( 10 ), c * natural( 4 ) ) == c * natural( 2 ) );
+	sub_shift_right( c, d );
+	assert( c == natural( 1 ) );
+	for ( std::size_t sh : { 0, 3, 8, 13, 40 } ) {
+		natural n = natural( 3 ).power( 20 ) + natural( 1 );
+		assert( ( ( n <<= sh ) >>= sh ) == natural( 3 ).power( 20 ) + natural( 1 ) );
+		natural m = n;
+		assert( ( m <<= sh ) == n * natural( 2 ).power( sh ) );
+		assert( sub_shifted( m, n, sh ) && m == natural( 0 ) );
+	}
+
+	real x( false, natural( 6 ), natural( 8 ) );
+	x.normalize();
+	assert( x._p == natural( 3 ) && x._q == natural( 4 ) );
+	real third = real( 1 ) / 3, sum = 0;
+	for ( int i = 0; i < 30; ++i ) sum += third;
+	assert( sum == real( 10 ) );
+	assert( sum._pending < real::normalize_period );
+	assert( sum._q.digit_count() <= 2 );
+
+	assert( real( INT_MIN )._sign && real( INT_MIN )._p == natural( INT_MAX ) + natural( 1 ) );
+	assert( real( INT_MIN ) + real( INT_MAX ) == real( -1 ) );
+}
+
+//	size of the operands and run time of the plain exp( 1 ) series for different
+//	normalisation periods ( INT_MAX means no normalisation at all )
+void bench_normalize() {
+	for ( int period : { 1, 2, 4, 8, 16, INT_MAX } ) {
+		real::normalize_period = period;
+		auto start = std::chrono::steady_clock::now();
+		real r = 1, term = 1, eps = real( 10 ).power( -150 );
+		for ( int k = 1; term >= eps; ++k ) {
+			term /= k;
+			r += term;
+		}
+		std::chrono::duration<double> took = std::chrono::steady_clock::now() - start;
+		std::cout << "period " << period << ": " << took.count() << " s, digits " 
+				  << r._p.digit_count() << " / " << r._q.digit_count() << std::endl;
+	}
+	real::normalize_period = 4;
+}
+
+void test_series() {
+	std::cout << "TEST SERIES" << std::endl;
+	real eps = real( 10 ).power( -40 ), ten_50 = real( 10 ).power( 50 );
+	real e = real( false, parse( "271828182845904523536028747135266249775724709369995" ), natural( 1 ) ) / ten_50;
+	real l_half = real( false, parse( "40546510810816438197801311546434913657199042346249" ), natural( 1 ) ) / ten_50;
+	real e_m25 = real( false, parse( "8208499862389879516952867446715980783780412101543" ), natural( 1 ) ) / ten_50;
+	real l_m34 = -real( false, parse( "138629436111989061883446424291635313615100026872051" ), natural( 1 ) ) / ten_50;
+
+	assert( ( real( 1 ).exp( eps ) - e ).abs() < eps );
+	assert( ( ( real( -5 ) / 2 ).exp( eps ) - e_m25 ).abs() < eps );
+	assert( ( ( real( 1 ) / 2 ).log1p( eps ) - l_half ).abs() < eps );
+	assert( ( ( real( -3 ) / 4 ).log1p( eps ) - l_m34 ).abs() < eps );
+	assert( real( 0 ).exp( eps ) == real( 1 ) );
+	assert( real( 0 ).log1p( eps ) == real( 0 ) );
+
+	// near -1, where the argument reduction keeps the series short
+	real l_1000 = real( false, parse( "690775527898213705205397436405309262280330446588632" ), natural( 1 ) ) / ten_50;
+	real l_2_40 = real( false, parse( "2772588722239781237668928485832706272302000537441021" ), natural( 1 ) ) / ten_50;
+	assert( ( ( real( -999 ) / 1000 ).log1p( eps ) + l_1000 ).abs() < eps );
+	real near = -real( false, power_of_two( 40 ) - natural( 1 ), power_of_two( 40 ) );
+	assert( ( near.log1p( eps ) + l_2_40 ).abs() < eps );
+	assert( ( near.log1p( real( 1 ) / 1000 ) + l_2_40 ).abs() < real( 1 ) / 1000 );
+
+	real x = real( 1 ) / 3;
+	assert( ( x.exp( eps ) * ( -x ).exp( eps ) - real( 1 ) ).abs() < eps * 3 );
+	assert( ( ( x.exp( eps ) - real( 1 ) ).log1p( eps ) - x ).abs() < eps * 10 );
+	assert( x.exp( eps )._q.digit_count() <= 20 );
+}
+
+void test_newton() {
+	std::cout << "TEST NEWTON" << std::endl;
+	real eps = real( 10 ).power( -40 ), ten_50 = real( 10 ).power( 50 );
+	real sqrt2 = real( false, parse( "141421356237309504880168872420969807856967187537694" ), natural( 1 ) ) / ten_50;
+	real sqrt03 = real( false, parse( "54772255750516611345696978280080213395274469499798" ), natural( 1 ) ) / ten_50;
+	assert( ( real( 2 ).sqrt( eps ) - sqrt2 ).abs() < eps );
+	assert( ( ( real( 3 ) / 10 ).sqrt( eps ) - sqrt03 ).abs() < eps );
+	assert( ( ( real( 1 ) / 4 ).sqrt( eps ) - real( 1 ) / 2 ).abs() < eps );
+	assert( ( real( 10 ).power( 40 ).sqrt( eps ) - real( 10 ).power( 20 ) ).abs() < eps );
+	assert( ( real( 10 ).power( -60 ).sqrt( eps ) - real( 10 ).power( -30 ) ).abs() < eps );
+	assert( real( 0 ).sqrt( eps ) == real( 0 ) );
+
+	assert( ( real( 3 ).reciprocal( eps ) - real( 1 ) / 3 ).abs() < eps );
+	assert( ( real( -7 ).reciprocal( eps ) - real( -1 ) / 7 ).abs() < eps );
+	assert( ( ( real( 3 ) / 7 ).reciprocal( eps ) - real( 7 ) / 3 ).abs() < eps );
+	assert( ( real( 10 ).power( -30 ).reciprocal( eps ) - real( 10 ).power( 30 ) ).abs() < eps );
+	assert( ( real( 10 ).power( 30 ).reciprocal( eps ) - real( 10 ).power( -30 ) ).abs() < eps );
+}
+
+void bench_newton() {
+	for ( int digits : { 100, 200, 400, 800, 1600, 3200 } ) {
+		real eps = real( 10 ).power( -digits );
+		auto start = std::chrono::steady_clock::now();
+		real root = real( 2 ).sqrt( eps );
+		std::chrono::duration<double> sqrt_took = std::chrono::steady_clock::now() - start;
+		start = std::chrono::steady_clock::now();
+		real inv = real( 3 ).reciprocal( eps );
+		std::chrono::duration<double> inv_took = std::chrono::steady_clock::now() - start;
+		start = std::chrono::steady_clock::now();
+		natural sq = root._p * inv._p;
+		std::chrono::duration<double> mul_took = std::chrono::steady_clock::now() - start;
+		std::cout << digits << " digits: sqrt " << sqrt_took.count() << " s, reciprocal " 
+				  << inv_took.count() << " s, one multiplication " << mul_took.count() << " s" << std::endl;
+	}
+}
+
+void bench_series() {
+	for ( int digits : { 50, 100, 200, 400, 800 } ) {
+		real eps = real( 10 ).power( -digits );
+		auto start = std::chrono::steady_clock::now();
+		real e = real( 1 ).exp( eps );
+		std::chrono::duration<double> exp_took = std::chrono::steady_clock::now() - start;
+		start = std::chrono::steady_clock::now();
+		real l = ( real( 1 ) / 2 ).log1p( eps );
+		std::chrono::duration<double> log_took = std::chrono::steady_clock::now() - start;
+		std::cout << digits << " digits: exp " << exp_took.count() << " s, log1p " 
+				  << log_took.count() << " s" << std::endl;
+	}
+}
+
 int main()
 {
     real zero = 0;
@@ -455,5 +1000,12 @@ int main()
     assert( one + -one == zero );
     assert( one * ten == ten );
 
+    test_gcd();
+    test_series();
+    test_newton();
+    //bench_series();
+    //bench_newton();
+    //bench_normalize();
+
     return 0;
 }
\ No newline at end of file